@@ -0,0 +1,134 @@
+import argparse
+import math
+import random
+import time
+
+from smo_food_center import SMO, TraceLevel, EVENT_SETS, RandomStream, ExponentialStream
+from smo_native import NativeSMO, native_available
+
+
+# Сценарии для замеров: параметры конструктора SMO + горизонт моделирования.
+SCENARIOS = {
+    # конфигурация из main(): низкая загрузка, мало событий в календаре
+    "main": (dict(num_restaurants=15, num_operators=5, interval=10.0,
+                  op_mean=2.0, buffer_cap=3), 20000.0),
+    # параметры SMO по умолчанию: перегрузка, буфер всегда полон
+    "default": (dict(), 2000.0),
+    # крупная модель: сотни операторов, длинный календарь
+    "large": (dict(num_restaurants=200, num_operators=500, interval=2.0,
+                   op_mean=4.5, buffer_cap=100), 200.0),
+}
+
+
+def run_once(params: dict, t_max: float, **options) -> float:
+    smo = SMO(**params, **options)
+    step = smo.step
+    events = 0
+    start = time.perf_counter()
+    while smo.time < t_max and step():
+        events += 1
+    elapsed = time.perf_counter() - start
+    return events / elapsed if elapsed > 0 else 0.0
+
+
+def best_of(repeat: int, params: dict, t_max: float, **options) -> float:
+    return max(run_once(params, t_max, **options) for _ in range(repeat))
+
+
+def bench_trace_levels(names, repeat: int):
+    print("\n=== Уровни трассировки (событий/с) ===")
+    print(f"{'сценарий':<10}" + "".join(f"{lvl.name:>12}" for lvl in TraceLevel) + f"{'OFF/FULL':>10}")
+    for name in names:
+        params, t_max = SCENARIOS[name]
+        rates = {lvl: best_of(repeat, params, t_max, trace=lvl) for lvl in TraceLevel}
+        gain = rates[TraceLevel.OFF] / rates[TraceLevel.FULL]
+        print(f"{name:<10}" + "".join(f"{rates[lvl]:>12.0f}" for lvl in TraceLevel) + f"{gain:>9.2f}x")
+
+
+def bench_event_sets(names, repeat: int):
+    print("\n=== Календари событий, TraceLevel.OFF (событий/с) ===")
+    print(f"{'сценарий':<10}" + "".join(f"{es:>12}" for es in EVENT_SETS))
+    for name in names:
+        params, t_max = SCENARIOS[name]
+        rates = [best_of(repeat, params, t_max, event_set=es, trace=TraceLevel.OFF) for es in EVENT_SETS]
+        print(f"{name:<10}" + "".join(f"{r:>12.0f}" for r in rates))
+    print("heap (по умолчанию) — heapq на C; calendar и indexed написаны на Python\n"
+          "и на этих размерах медленнее, они оставлены для сравнения дисциплин календаря")
+
+
+def bench_service_draws(repeat: int, draws: int = 1_000_000):
+    # Стоимость одного времени обслуживания П32 (нс, вместе с вызовом функции):
+    # голый expovariate, логарифм поверх равномерного потока и expovariate
+    # потока оператора со счётом позиции (нужен снимкам), как в
+    # Operator.start_service
+    rate = 0.5
+
+    def per_draw(make_draw) -> float:
+        best = math.inf
+        for _ in range(repeat):
+            draw = make_draw()
+            start = time.perf_counter()
+            for _ in range(draws):
+                draw()
+            best = min(best, time.perf_counter() - start)
+        return best / draws * 1e9
+
+    def expovariate():
+        gen = random.Random(1)
+        return lambda: gen.expovariate(rate)
+
+    def uniform_log():
+        nxt = RandomStream(1).next
+        log = math.log
+        return lambda: -log(1.0 - nxt()) / rate
+
+    def exponential_stream():
+        stream = ExponentialStream(1)
+
+        def draw():
+            value = stream.expovariate(rate)
+            stream.drawn += 1
+            return value
+        return draw
+
+    print("\n=== Время обслуживания П32 (нс на значение) ===")
+    for label, make in (("random.expovariate", expovariate),
+                        ("RandomStream + log", uniform_log),
+                        ("ExponentialStream", exponential_stream)):
+        print(f"{label:<22}{per_draw(make):>8.1f}")
+
+
+def bench_native(names, repeat: int):
+    if not native_available():
+        print("\n(нативный движок не собран — замер пропущен)")
+        return
+    print("\n=== Python (TraceLevel.OFF) против нативного движка (событий/с) ===")
+    print(f"{'сценарий':<10}{'python':>12}{'native':>14}{'ускорение':>12}")
+    for name in names:
+        params, t_max = SCENARIOS[name]
+        py_rate = best_of(repeat, params, t_max, trace=TraceLevel.OFF)
+        native_rate = 0.0
+        for _ in range(repeat):
+            smo = NativeSMO(**params)
+            start = time.perf_counter()
+            events = smo.run_until(t_max)
+            native_rate = max(native_rate, events / (time.perf_counter() - start))
+        print(f"{name:<10}{py_rate:>12.0f}{native_rate:>14.0f}{native_rate / py_rate:>11.1f}x")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Замеры производительности SMO")
+    parser.add_argument("--scenario", action="append", choices=sorted(SCENARIOS),
+                        help="сценарий (можно несколько), по умолчанию все")
+    parser.add_argument("--repeat", type=int, default=3, help="повторов на замер (берётся лучший)")
+    args = parser.parse_args()
+
+    names = args.scenario or list(SCENARIOS)
+    bench_trace_levels(names, args.repeat)
+    bench_event_sets(names, args.repeat)
+    bench_service_draws(args.repeat)
+    bench_native(names, args.repeat)
+
+
+if __name__ == "__main__":
+    main()
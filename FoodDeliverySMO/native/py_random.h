@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace smo {
+
+// Mersenne Twister MT19937, побитово совместимый с модулем random CPython:
+// тот же init_by_array при seed(int), тот же random() из двух 32-битных слов
+// и тот же expovariate(). На нём построены потоки RandomStream, поэтому
+// нативный движок получает ровно те же времена обслуживания, что и SMO.
+class PyRandom {
+public:
+    explicit PyRandom(uint64_t seed = 0) { seed_u64(seed); }
+    struct NoSeed {};
+    explicit PyRandom(NoSeed) {}
+
+    // random.seed(n): ключ — 32-битные слова |n| от младших к старшим
+    void seed_u64(uint64_t seed) {
+        PyRandom* self = this;
+        init_by_array<1>(&self, &seed);
+    }
+
+    // seed_u64 для нескольких генераторов сразу: цепочка init_by_array
+    // последовательная, и засев по одному упирается в её задержку, а
+    // 4–8 независимых цепочек вперемешку процессор считает параллельно
+    static void seed_u64_many(PyRandom* const* gens, const uint64_t* seeds, size_t count) {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+            init_by_array<8>(gens + i, seeds + i);
+        for (; i + 4 <= count; i += 4)
+            init_by_array<4>(gens + i, seeds + i);
+        for (; i < count; ++i)
+            init_by_array<1>(gens + i, seeds + i);
+    }
+
+    uint32_t next_u32() {
+        if (index_ >= twisted_)
+            twist(1);
+        uint32_t y = mt_[index_++];
+        y ^= (y >> 11);
+        y ^= (y << 7) & 0x9d2c5680U;
+        y ^= (y << 15) & 0xefc60000U;
+        y ^= (y >> 18);
+        return y;
+    }
+
+    // random.random(): 53-битное число из [0, 1)
+    double random() {
+        uint32_t a = next_u32() >> 5;
+        uint32_t b = next_u32() >> 6;
+        return (a * 67108864.0 + b) * (1.0 / 9007199254740992.0);
+    }
+
+    // Пропуск count 32-битных слов (как getrandbits(32 * count)): целыми
+    // перемешиваниями состояния, без закалки пропущенных слов
+    void discard(uint64_t count) {
+        while (count) {
+            if (index_ >= twisted_)
+                twist(static_cast<int>(std::min<uint64_t>(count, N)));
+            const uint64_t take = std::min<uint64_t>(count, static_cast<uint64_t>(twisted_ - index_));
+            index_ += static_cast<int>(take);
+            count -= take;
+        }
+    }
+
+    // random.expovariate(lambd)
+    double expovariate(double lambd) {
+        return -std::log(1.0 - random()) / lambd;
+    }
+
+private:
+    static constexpr int N = 624;
+
+    static constexpr int M = 397;
+
+    void init_genrand(uint32_t s) {
+        mt_[0] = s;
+        for (int i = 1; i < N; ++i)
+            mt_[i] = 1812433253U * (mt_[i - 1] ^ (mt_[i - 1] >> 30)) + static_cast<uint32_t>(i);
+        index_ = twisted_ = N;
+    }
+
+    // Засев на каждый поток RandomStream, поэтому init_by_array важен
+    // для скорости: начальное состояние init_genrand(19650218) от ключа не
+    // зависит и копируется из таблицы, а предыдущее слово цепочки держится
+    // в регистре вместо повторного чтения mt_[i - 1]. Ключ — одно слово, если
+    // старшая половина seed нулевая, иначе два; слагаемое key[j] + j
+    // чередуется по чётности шага, и номер i у всех цепочек общий.
+    template <int LANES>
+    static void init_by_array(PyRandom* const* gens, const uint64_t* seeds) {
+        static const PyRandom base = [] {
+            PyRandom r(NoSeed{});
+            r.init_genrand(19650218U);
+            return r;
+        }();
+        uint32_t prev[LANES];
+        uint32_t add[LANES][2];
+        for (int l = 0; l < LANES; ++l) {
+            std::memcpy(gens[l]->mt_, base.mt_, sizeof(base.mt_));
+            gens[l]->index_ = gens[l]->twisted_ = N;
+            prev[l] = base.mt_[0];
+            add[l][0] = static_cast<uint32_t>(seeds[l]);
+            add[l][1] = (seeds[l] >> 32) ? static_cast<uint32_t>(seeds[l] >> 32) + 1U : add[l][0];
+        }
+
+        int i = 1;
+        for (int k = 0; k < N; ++k) {
+            for (int l = 0; l < LANES; ++l) {
+                uint32_t* mt = gens[l]->mt_;
+                prev[l] = (mt[i] ^ ((prev[l] ^ (prev[l] >> 30)) * 1664525U)) + add[l][k & 1];
+                mt[i] = prev[l];
+            }
+            if (++i >= N) {
+                for (int l = 0; l < LANES; ++l)
+                    gens[l]->mt_[0] = prev[l];
+                i = 1;
+            }
+        }
+        for (int k = N - 1; k; --k) {
+            for (int l = 0; l < LANES; ++l) {
+                uint32_t* mt = gens[l]->mt_;
+                prev[l] = (mt[i] ^ ((prev[l] ^ (prev[l] >> 30)) * 1566083941U)) - static_cast<uint32_t>(i);
+                mt[i] = prev[l];
+            }
+            if (++i >= N) {
+                for (int l = 0; l < LANES; ++l)
+                    gens[l]->mt_[0] = prev[l];
+                i = 1;
+            }
+        }
+        for (int l = 0; l < LANES; ++l)
+            gens[l]->mt_[0] = 0x80000000U;
+    }
+
+    // Перемешивание по частям: слова нового поколения считаются по порядку
+    // и не раньше, чем понадобятся (не меньше need штук и блоками по
+    // TWIST_BLOCK). Слово kk < N - M читает ещё не переписанные mt_[kk + 1]
+    // и mt_[kk + M], остальные — уже новые слова с меньшими номерами, так что
+    // результат тот же, что у перемешивания всего состояния сразу. Потоку,
+    // из которого за прогон берут пару десятков чисел, не нужны все 624 слова.
+    static constexpr int TWIST_BLOCK = 32;
+
+    void twist(int need) {
+        static constexpr uint32_t MATRIX_A = 0x9908b0dfU;
+        static constexpr uint32_t UPPER_MASK = 0x80000000U;
+        static constexpr uint32_t LOWER_MASK = 0x7fffffffU;
+        if (twisted_ >= N)
+            index_ = twisted_ = 0;
+        const int end = std::min(N, twisted_ + std::max(need, TWIST_BLOCK));
+        int kk = twisted_;
+        for (; kk < std::min(end, N - M); ++kk) {
+            uint32_t y = (mt_[kk] & UPPER_MASK) | (mt_[kk + 1] & LOWER_MASK);
+            mt_[kk] = mt_[kk + M] ^ (y >> 1) ^ ((y & 1U) ? MATRIX_A : 0U);
+        }
+        for (; kk < std::min(end, N - 1); ++kk) {
+            uint32_t y = (mt_[kk] & UPPER_MASK) | (mt_[kk + 1] & LOWER_MASK);
+            mt_[kk] = mt_[kk + (M - N)] ^ (y >> 1) ^ ((y & 1U) ? MATRIX_A : 0U);
+        }
+        if (kk < end) {
+            uint32_t y = (mt_[N - 1] & UPPER_MASK) | (mt_[0] & LOWER_MASK);
+            mt_[N - 1] = mt_[M - 1] ^ (y >> 1) ^ ((y & 1U) ? MATRIX_A : 0U);
+        }
+        twisted_ = end;
+    }
+
+    uint32_t mt_[N];
+    int index_ = N;
+    int twisted_ = N;   // mt_[0, twisted_) — уже слова нового поколения
+};
+
+}  // namespace smo
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "py_random.h"
+
+namespace smo {
+
+constexpr uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ULL;
+
+// splitmix64 / split_key / RandomStream — те же функции, что в smo_food_center.py
+inline uint64_t splitmix64(uint64_t x) {
+    uint64_t z = x + GOLDEN_GAMMA;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t split_key(uint64_t key, uint64_t index) {
+    return splitmix64(key ^ splitmix64(index));
+}
+
+constexpr uint64_t STREAM_OPERATOR = 1;
+constexpr uint64_t STREAM_RESTAURANT = 2;
+
+// Антитетичная пара к u = k / 2^53: ANTITHETIC_ONE - u, точно как в Python
+constexpr double ANTITHETIC_ONE = 1.0 - 0x1p-53;
+
+// Поток случайных чисел: MT19937 (PyRandom), засеянный один раз значением
+// splitmix64(key), как RandomStream в smo_food_center.py. EXPONENTIAL —
+// аналог ExponentialStream: числа сразу преобразуются в Exp(1) = -log(1 - u).
+// Числа считаются порциями: первая — FIRST_CHUNK, дальше каждая вдвое больше
+// предыдущей, до CHUNK. Генератор засевается при первом обращении к потоку:
+// сотни операторов, которые за прогон обслуживают пару десятков заказов,
+// не платят ни за засев, ни за лишние значения.
+enum class StreamKind {
+    UNIFORM,
+    EXPONENTIAL,
+};
+
+class RandomStream {
+public:
+    static constexpr int CHUNK = 64;
+    static constexpr int FIRST_CHUNK = 16;
+
+    explicit RandomStream(uint64_t key = 0, StreamKind kind = StreamKind::UNIFORM, bool antithetic = false)
+        : key_(key), kind_(kind), antithetic_(antithetic) {}
+
+    RandomStream split(uint64_t index) const {
+        return RandomStream(split_key(key_, index), kind_, antithetic_);
+    }
+
+    double next() {
+        if (cur_ == end_)
+            refill();
+        return buf_[cur_++];
+    }
+
+    // Сколько значений уже выдано (RandomStream.tell); seek(n) — следующим
+    // будет n-е значение: генератор засевается заново и пропускает n значений
+    // при первом next()
+    uint64_t tell() const { return start_ + static_cast<uint64_t>(cur_); }
+
+    void seek(uint64_t n) {
+        start_ = n;
+        cur_ = end_ = 0;
+        seeded_ = false;
+    }
+
+    // Засев сразу нескольких ещё не засеянных потоков (PyRandom::seed_u64_many);
+    // значения те же, что при засеве каждого в первом next()
+    bool seeded() const { return seeded_; }
+
+    static void seed_many(RandomStream* const* streams, size_t count) {
+        static constexpr size_t MAX = 8;
+        PyRandom* gens[MAX];
+        uint64_t seeds[MAX];
+        for (size_t done = 0; done < count; done += MAX) {
+            const size_t n = std::min(MAX, count - done);
+            for (size_t i = 0; i < n; ++i) {
+                gens[i] = &streams[done + i]->gen_;
+                seeds[i] = splitmix64(streams[done + i]->key_);
+            }
+            PyRandom::seed_u64_many(gens, seeds, n);
+            for (size_t i = 0; i < n; ++i)
+                streams[done + i]->after_seed();
+        }
+    }
+
+    uint64_t key() const { return key_; }
+    StreamKind kind() const { return kind_; }
+    bool antithetic() const { return antithetic_; }
+
+private:
+    void refill() {
+        start_ += static_cast<uint64_t>(end_);
+        if (!seeded_) {
+            gen_.seed_u64(splitmix64(key_));
+            after_seed();
+        }
+        const int n = std::min(CHUNK, std::max(FIRST_CHUNK, 2 * end_));
+        for (int i = 0; i < n; ++i)
+            buf_[i] = gen_.random();
+        if (antithetic_) {
+            for (int i = 0; i < n; ++i)
+                buf_[i] = ANTITHETIC_ONE - buf_[i];
+        }
+        // тот же std::log, что в PyRandom::expovariate; без -ffast-math и
+        // векторного libm — иначе значения разошлись бы с Python-версией
+        if (kind_ == StreamKind::EXPONENTIAL) {
+            for (int i = 0; i < n; ++i)
+                buf_[i] = -std::log(1.0 - buf_[i]);
+        }
+        cur_ = 0;
+        end_ = n;
+    }
+
+    // незасеянный поток ничего не посчитал (end_ == 0), так что start_ —
+    // номер следующего значения
+    void after_seed() {
+        gen_.discard(2 * start_);   // random() берёт два 32-битных слова
+        seeded_ = true;
+    }
+
+    uint64_t key_;
+    StreamKind kind_;
+    bool antithetic_;
+    bool seeded_ = false;
+    uint64_t start_ = 0;   // номер значения buf_[0] в потоке
+    int cur_ = 0;          // buf_[cur_, end_) — посчитанные, но ещё не выданные
+    int end_ = 0;
+    double buf_[CHUNK];
+    PyRandom gen_{PyRandom::NoSeed{}};
+};
+
+}  // namespace smo
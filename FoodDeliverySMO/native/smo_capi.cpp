@@ -0,0 +1,221 @@
+#include "smo_capi.h"
+
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "smo_engine.h"
+
+struct SmoEngine {
+    smo::Engine engine;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+// Исключение не должно выйти за extern "C": ctypes его не ловит, и процесс
+// завершился бы через std::terminate. Каждая точка входа выполняется через
+// guarded: при исключении возвращается fallback, текст — в smo_last_error.
+template <typename R, typename F>
+R guarded(R fallback, F&& body) noexcept {
+    try {
+        last_error.clear();
+        return body();
+    } catch (const std::exception& e) {
+        try {
+            last_error = e.what();
+        } catch (...) {
+        }
+    } catch (...) {
+        try {
+            last_error = "неизвестная ошибка";
+        } catch (...) {
+        }
+    }
+    return fallback;
+}
+
+void check_config(const smo::Config& config) {
+    if (config.num_restaurants < 0 || config.num_operators < 0 || config.buffer_cap < 0)
+        throw std::invalid_argument("число ресторанов, операторов и ёмкость буфера должны быть >= 0");
+    if (!(config.interval > 0.0) || !std::isfinite(config.interval))
+        throw std::invalid_argument("интервал поступлений должен быть конечным и > 0");
+    if (!(config.op_mean > 0.0) || !std::isfinite(config.op_mean))
+        throw std::invalid_argument("среднее время обслуживания должно быть конечным и > 0");
+}
+
+constexpr double NO_VALUE = std::numeric_limits<double>::quiet_NaN();
+
+}  // namespace
+
+extern "C" {
+
+const char* smo_last_error(void) {
+    return last_error.c_str();
+}
+
+SmoEngine* smo_create(int32_t num_restaurants, int32_t num_operators, double interval,
+                      double op_mean, int32_t buffer_cap, uint64_t seed,
+                      int32_t crn, int32_t antithetic) {
+    return guarded<SmoEngine*>(nullptr, [&] {
+        smo::Config config;
+        config.num_restaurants = num_restaurants;
+        config.num_operators = num_operators;
+        config.interval = interval;
+        config.op_mean = op_mean;
+        config.buffer_cap = buffer_cap;
+        config.seed = seed;
+        config.crn = crn != 0;
+        config.antithetic = antithetic != 0;
+        check_config(config);
+        return new SmoEngine{smo::Engine(config)};
+    });
+}
+
+void smo_destroy(SmoEngine* engine) {
+    guarded(0, [&] {
+        delete engine;
+        return 0;
+    });
+}
+
+int32_t smo_step(SmoEngine* engine) {
+    return guarded(-1, [&] { return engine->engine.step() ? 1 : 0; });
+}
+
+int64_t smo_run_until(SmoEngine* engine, double t_max) {
+    return guarded<int64_t>(-1, [&] { return static_cast<int64_t>(engine->engine.run_until(t_max)); });
+}
+
+int64_t smo_run_events(SmoEngine* engine, double t_max, uint64_t max_events) {
+    return guarded<int64_t>(-1, [&] { return static_cast<int64_t>(engine->engine.run_until(t_max, max_events)); });
+}
+
+uint64_t smo_checkpoint(const SmoEngine* engine, uint8_t* out, uint64_t capacity) {
+    return guarded<uint64_t>(0, [&] {
+        const std::vector<uint8_t> data = engine->engine.checkpoint();
+        if (data.size() <= capacity)
+            std::memcpy(out, data.data(), data.size());
+        return static_cast<uint64_t>(data.size());
+    });
+}
+
+SmoEngine* smo_restore(const uint8_t* data, uint64_t size) {
+    return guarded<SmoEngine*>(nullptr, [&] {
+        return new SmoEngine{smo::Engine::restore(data, static_cast<size_t>(size))};
+    });
+}
+
+double smo_time(const SmoEngine* engine) {
+    return guarded(NO_VALUE, [&] { return engine->engine.time(); });
+}
+
+int32_t smo_reset_statistics(SmoEngine* engine) {
+    return guarded(-1, [&] {
+        engine->engine.reset_statistics();
+        return 0;
+    });
+}
+
+double smo_stats_start(const SmoEngine* engine) {
+    return guarded(NO_VALUE, [&] { return engine->engine.stats_start(); });
+}
+
+int32_t smo_enable_batch_means(SmoEngine* engine, int32_t max_batches) {
+    return guarded(-1, [&] {
+        if (max_batches < 2 || max_batches % 2)
+            throw std::invalid_argument("max_batches должно быть чётным и не меньше 2");
+        engine->engine.enable_batch_means(max_batches);
+        return 0;
+    });
+}
+
+int32_t smo_batch_means(const SmoEngine* engine, int32_t which, double* sums, double* weights,
+                        int32_t capacity, double* state) {
+    return guarded(-2, [&] {
+        const smo::BatchMeansSet* set = engine->engine.batch_means();
+        if (!set)
+            return -1;
+        const smo::BatchMeans& bm = which == 0 ? set->wait : which == 1 ? set->system : set->buffer;
+        const int32_t n = static_cast<int32_t>(bm.sums().size());
+        for (int32_t i = 0; i < n && i < capacity; ++i) {
+            sums[i] = bm.sums()[static_cast<size_t>(i)];
+            weights[i] = bm.weights()[static_cast<size_t>(i)];
+        }
+        state[0] = bm.size();
+        state[1] = bm.partial_sum();
+        state[2] = bm.partial_weight();
+        return n;
+    });
+}
+
+int32_t smo_enable_regenerative(SmoEngine* engine) {
+    return guarded(-1, [&] {
+        engine->engine.enable_regenerative();
+        return 0;
+    });
+}
+
+int64_t smo_regenerative(const SmoEngine* engine, SmoRatioStats* out) {
+    return guarded<int64_t>(-2, [&] {
+        const smo::RegenerationSet* set = engine->engine.regenerative();
+        if (!set)
+            return int64_t{-1};
+        for (int i = 0; i < smo::RegenerationSet::METRICS; ++i) {
+            const smo::RatioStats& rs = set->stats[i];
+            out[i] = SmoRatioStats{rs.count, rs.mean_y, rs.mean_x, rs.cyy, rs.cxx, rs.cxy};
+        }
+        return static_cast<int64_t>(set->stats[0].count);
+    });
+}
+
+double smo_buffer_area(const SmoEngine* engine) {
+    return guarded(NO_VALUE, [&] { return engine->engine.buffer_area(); });
+}
+
+int32_t smo_buffer_length(const SmoEngine* engine) {
+    return guarded(-1, [&] { return static_cast<int32_t>(engine->engine.buffer_length()); });
+}
+
+int32_t smo_totals(const SmoEngine* engine, uint64_t* out) {
+    return guarded(-1, [&] {
+        out[0] = engine->engine.total_generated();
+        out[1] = engine->engine.total_processed();
+        out[2] = engine->engine.total_rejected();
+        return 0;
+    });
+}
+
+static SmoRunningStats to_c(const smo::RunningStats& st) {
+    return SmoRunningStats{st.count, st.mean, st.m2, st.min, st.max};
+}
+
+int32_t smo_restaurant_stats(const SmoEngine* engine, int64_t* generated, uint64_t* rejected,
+                             SmoRunningStats* wait, SmoRunningStats* system) {
+    return guarded(-1, [&] {
+        const auto& restaurants = engine->engine.restaurants();
+        const auto& stats = engine->engine.restaurant_stats();
+        for (size_t i = 0; i < stats.size(); ++i) {
+            generated[i] = restaurants[i].generated - restaurants[i].generated_base;
+            rejected[i] = stats[i].rejected;
+            wait[i] = to_c(stats[i].wait);
+            system[i] = to_c(stats[i].system);
+        }
+        return 0;
+    });
+}
+
+int32_t smo_operator_busy_time(const SmoEngine* engine, double* busy_time) {
+    return guarded(-1, [&] {
+        const auto& operators = engine->engine.operators();
+        for (size_t i = 0; i < operators.size(); ++i)
+            busy_time[i] = operators[i].busy_time;
+        return 0;
+    });
+}
+
+}  // extern "C"
@@ -0,0 +1,96 @@
+#pragma once
+
+// C-интерфейс нативного движка для загрузки из Python (ctypes, smo_native.py).
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define SMO_API __declspec(dllexport)
+#else
+#define SMO_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SmoEngine SmoEngine;
+
+// Исключения движка наружу не выходят: при ошибке функция возвращает
+// NULL, -1 (у smo_batch_means и smo_regenerative -2), 0 у smo_checkpoint
+// или NaN, а smo_last_error — текст последней ошибки в этом потоке.
+SMO_API const char* smo_last_error(void);
+
+// Накопитель Уэлфорда (RunningStats в SMO)
+typedef struct SmoRunningStats {
+    uint64_t count;
+    double mean;
+    double m2;
+    double min;
+    double max;
+} SmoRunningStats;
+
+// crn, antithetic — 0/1, как одноимённые параметры SMO; NULL — неверные
+// параметры (отрицательные размеры, interval или op_mean не > 0) или не
+// хватило памяти
+SMO_API SmoEngine* smo_create(int32_t num_restaurants, int32_t num_operators, double interval,
+                              double op_mean, int32_t buffer_cap, uint64_t seed,
+                              int32_t crn, int32_t antithetic);
+SMO_API void smo_destroy(SmoEngine* engine);
+
+// 1 — событие обработано, 0 — календарь пуст
+SMO_API int32_t smo_step(SmoEngine* engine);
+// шаги, пока time < t_max; возвращает число обработанных событий
+SMO_API int64_t smo_run_until(SmoEngine* engine, double t_max);
+
+// SMO.reset_statistics; smo_stats_start — момент последнего сброса
+SMO_API int32_t smo_reset_statistics(SmoEngine* engine);
+SMO_API double smo_stats_start(const SmoEngine* engine);
+
+// SMO(batch_means=True). smo_batch_means: which — 0 ожидание, 1 пребывание,
+// 2 длина буфера; пишет до capacity полных пакетов в sums/weights и
+// state[0..2] = size, сумма и вес текущего пакета; возвращает число полных
+// пакетов (-1 — пакетные средние не включены)
+SMO_API int32_t smo_enable_batch_means(SmoEngine* engine, int32_t max_batches);
+SMO_API int32_t smo_batch_means(const SmoEngine* engine, int32_t which, double* sums, double* weights,
+                                int32_t capacity, double* state);
+
+// SMO(regenerative=True). smo_regenerative пишет out[0..4] — RatioStats в
+// порядке REGENERATIVE_METRICS; возвращает число законченных циклов (-1 —
+// циклы регенерации не включены)
+typedef struct SmoRatioStats {
+    uint64_t count;
+    double mean_y;
+    double mean_x;
+    double cyy;
+    double cxx;
+    double cxy;
+} SmoRatioStats;
+
+SMO_API int32_t smo_enable_regenerative(SmoEngine* engine);
+SMO_API int64_t smo_regenerative(const SmoEngine* engine, SmoRatioStats* out);
+
+// Снимок состояния (формат smo_checkpoint.py). smo_checkpoint пишет снимок
+// в out, если capacity хватает, и возвращает его размер — при нехватке
+// вызвать повторно с буфером нужного размера. smo_restore создаёт движок из
+// снимка; NULL — данные повреждены или не хватило памяти.
+SMO_API uint64_t smo_checkpoint(const SmoEngine* engine, uint8_t* out, uint64_t capacity);
+SMO_API SmoEngine* smo_restore(const uint8_t* data, uint64_t size);
+// smo_run_until, но не больше max_events событий
+SMO_API int64_t smo_run_events(SmoEngine* engine, double t_max, uint64_t max_events);
+
+SMO_API double smo_time(const SmoEngine* engine);
+SMO_API double smo_buffer_area(const SmoEngine* engine);
+SMO_API int32_t smo_buffer_length(const SmoEngine* engine);
+// out[0..2] = сгенерировано, обработано, отклонено
+SMO_API int32_t smo_totals(const SmoEngine* engine, uint64_t* out);
+
+// Массивы длины num_restaurants
+SMO_API int32_t smo_restaurant_stats(const SmoEngine* engine, int64_t* generated, uint64_t* rejected,
+                                     SmoRunningStats* wait, SmoRunningStats* system);
+// Массив длины num_operators
+SMO_API int32_t smo_operator_busy_time(const SmoEngine* engine, double* busy_time);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,432 @@
+// Снимок состояния Engine в формате smo_checkpoint.py: заголовок и столбцы
+// little-endian без выравнивания. Формат общий с Python-движком, так что
+// снимок одного движка продолжается другим.
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "smo_engine.h"
+
+namespace smo {
+
+namespace {
+
+constexpr char MAGIC[8] = {'S', 'M', 'O', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t VERSION = 2;  // см. VERSION в smo_checkpoint.py
+
+constexpr uint32_t FLAG_CRN = 1;
+constexpr uint32_t FLAG_ANTITHETIC = 2;
+constexpr uint32_t FLAG_BATCH_MEANS = 4;
+constexpr uint32_t FLAG_REGENERATIVE = 8;
+constexpr uint32_t KNOWN_FLAGS = FLAG_CRN | FLAG_ANTITHETIC | FLAG_BATCH_MEANS | FLAG_REGENERATIVE;
+
+// байт на строку столбцов (RESTAURANT_COLUMNS, OPERATOR_COLUMNS, заказ,
+// событие в smo_checkpoint.py)
+constexpr size_t RESTAURANT_ROW = 5 * 8 + 2 * (8 + 4 * 8);
+constexpr size_t OPERATOR_ROW = 1 + 4 + 3 * 8 + 8 + 4 + 8 + 2 * 8;
+constexpr size_t ORDER_ROW = 4 + 8 + 8 + 8;
+constexpr size_t EVENT_ROW = 8 + 8 + 4;
+constexpr uint64_t SEQ_MASK = (uint64_t{1} << 62) - 1;
+
+static_assert(std::endian::native == std::endian::little, "формат снимка — little-endian");
+
+class Writer {
+public:
+    template <typename T>
+    void put(T v) {
+        const size_t at = out.size();
+        out.resize(at + sizeof(T));
+        std::memcpy(out.data() + at, &v, sizeof(T));
+    }
+
+    // столбец: get(i) для i < n подряд
+    template <typename T, typename Get>
+    void column(size_t n, Get get) {
+        for (size_t i = 0; i < n; ++i)
+            put<T>(static_cast<T>(get(i)));
+    }
+
+    std::vector<uint8_t> out;
+};
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    T get() {
+        if (size_ - pos_ < sizeof(T))
+            throw std::invalid_argument("обрезан");
+        T v;
+        std::memcpy(&v, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return v;
+    }
+
+    template <typename T, typename Set>
+    void column(size_t n, Set set) {
+        if ((size_ - pos_) / sizeof(T) < n)
+            throw std::invalid_argument("обрезан");
+        for (size_t i = 0; i < n; ++i)
+            set(i, get<T>());
+    }
+
+    bool done() const { return pos_ == size_; }
+    size_t remaining() const { return size_ - pos_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+// текст — как у bad_checkpoint в smo_checkpoint.py
+void check(bool ok, const std::string& what) {
+    if (!ok)
+        throw std::invalid_argument(what);
+}
+
+void put_stats(Writer& w, const std::vector<RestaurantStats>& stats, RunningStats RestaurantStats::*field) {
+    const size_t n = stats.size();
+    w.column<uint64_t>(n, [&](size_t i) { return (stats[i].*field).count; });
+    w.column<double>(n, [&](size_t i) { return (stats[i].*field).mean; });
+    w.column<double>(n, [&](size_t i) { return (stats[i].*field).m2; });
+    w.column<double>(n, [&](size_t i) { return (stats[i].*field).min; });
+    w.column<double>(n, [&](size_t i) { return (stats[i].*field).max; });
+}
+
+void get_stats(Reader& r, std::vector<RestaurantStats>& stats, RunningStats RestaurantStats::*field) {
+    const size_t n = stats.size();
+    r.column<uint64_t>(n, [&](size_t i, uint64_t v) { (stats[i].*field).count = v; });
+    r.column<double>(n, [&](size_t i, double v) { (stats[i].*field).mean = v; });
+    r.column<double>(n, [&](size_t i, double v) { (stats[i].*field).m2 = v; });
+    r.column<double>(n, [&](size_t i, double v) { (stats[i].*field).min = v; });
+    r.column<double>(n, [&](size_t i, double v) { (stats[i].*field).max = v; });
+}
+
+void put_batch_means(Writer& w, const BatchMeans& bm) {
+    const size_t n = bm.sums().size();
+    w.put<int32_t>(bm.max_batches());
+    w.put<int32_t>(static_cast<int32_t>(n));
+    w.put<double>(bm.size());
+    w.put<double>(bm.partial_sum());
+    w.put<double>(bm.partial_weight());
+    w.column<double>(n, [&](size_t i) { return bm.sums()[i]; });
+    w.column<double>(n, [&](size_t i) { return bm.weights()[i]; });
+}
+
+BatchMeans get_batch_means(Reader& r) {
+    const int32_t max_batches = r.get<int32_t>();
+    const int32_t n = r.get<int32_t>();
+    check(max_batches >= 2 && max_batches % 2 == 0 && n >= 0 && n < max_batches, "неверные пакетные средние");
+    const double size = r.get<double>();
+    const double partial_sum = r.get<double>();
+    const double partial_weight = r.get<double>();
+    std::vector<double> sums(static_cast<size_t>(n)), weights(static_cast<size_t>(n));
+    r.column<double>(sums.size(), [&](size_t i, double v) { sums[i] = v; });
+    r.column<double>(weights.size(), [&](size_t i, double v) { weights[i] = v; });
+    BatchMeans bm(max_batches);
+    bm.set_state(size, std::move(sums), std::move(weights), partial_sum, partial_weight);
+    return bm;
+}
+
+}  // namespace
+
+std::vector<uint8_t> Engine::checkpoint() const {
+    Writer w;
+    const size_t n = restaurants_.size();
+    const size_t m = operators_.size();
+    const std::vector<Order> buffer = buffer_.orders();
+    const size_t len = buffer.size();
+
+    // между шагами вершина кучи всегда удалена (top_consumed_ == false);
+    // события — по возрастанию ключа, как пишет Python-движок
+    std::vector<Event> events = events_.items();
+    std::sort(events.begin(), events.end(), event_before);
+    // у свободного оператора поля текущего заказа не определены
+    const Order none{-1, -1, 0.0};
+    auto order = [&](size_t i) -> const Order& {
+        return operators_[i].busy ? operators_[i].current_order : none;
+    };
+
+    uint32_t flags = 0;
+    flags |= config_.crn ? FLAG_CRN : 0;
+    flags |= config_.antithetic ? FLAG_ANTITHETIC : 0;
+    flags |= batch_means_ ? FLAG_BATCH_MEANS : 0;
+    flags |= regen_ ? FLAG_REGENERATIVE : 0;
+
+    for (char c : MAGIC)
+        w.put<char>(c);
+    w.put<uint32_t>(VERSION);
+    w.put<uint32_t>(flags);
+    w.put<int32_t>(config_.num_restaurants);
+    w.put<int32_t>(config_.num_operators);
+    w.put<int32_t>(config_.buffer_cap);
+    w.put<int32_t>(static_cast<int32_t>(len));
+    w.put<double>(config_.interval);
+    w.put<double>(config_.op_mean);
+    w.put<uint64_t>(config_.seed);
+    w.put<double>(time_);
+    w.put<double>(last_event_time_);
+    w.put<double>(buffer_area_);
+    w.put<double>(stats_start_);
+    w.put<uint64_t>(total_generated_);
+    w.put<uint64_t>(total_processed_);
+    w.put<uint64_t>(total_rejected_);
+    w.put<uint64_t>(next_seq_);
+    w.put<uint64_t>(0);   // счётчики трассировки Python-движка: в нативном их нет
+    w.put<uint64_t>(0);
+    w.put<uint64_t>(events.size());
+
+    w.column<int64_t>(n, [&](size_t i) { return restaurants_[i].generated; });
+    w.column<int64_t>(n, [&](size_t i) { return restaurants_[i].generated_base; });
+    w.column<double>(n, [&](size_t i) { return restaurants_[i].next_time; });
+    w.column<uint64_t>(n, [&](size_t i) { return stats_[i].rejected; });
+    w.column<uint64_t>(n, [&](size_t i) { return config_.crn ? order_service_[i].tell() : 0; });
+    put_stats(w, stats_, &RestaurantStats::wait);
+    put_stats(w, stats_, &RestaurantStats::system);
+
+    w.column<uint8_t>(m, [&](size_t i) { return operators_[i].busy; });
+    w.column<int32_t>(m, [&](size_t i) { return operators_[i].batch_restaurant_id; });
+    w.column<double>(m, [&](size_t i) { return operators_[i].busy_time; });
+    w.column<double>(m, [&](size_t i) { return operators_[i].busy ? operators_[i].last_start_time : 0.0; });
+    w.column<double>(m, [&](size_t i) { return operators_[i].busy ? operators_[i].wait_time : 0.0; });
+    w.column<uint64_t>(m, [&](size_t i) { return operators_[i].stream.tell(); });
+    w.column<int32_t>(m, [&](size_t i) { return order(i).restaurant_id; });
+    w.column<int64_t>(m, [&](size_t i) { return order(i).order_id; });
+    w.column<double>(m, [&](size_t i) { return order(i).timestamp; });
+    w.column<double>(m, [&](size_t i) { return order(i).service_time; });
+
+    w.column<int32_t>(len, [&](size_t i) { return buffer[i].restaurant_id; });
+    w.column<int64_t>(len, [&](size_t i) { return buffer[i].order_id; });
+    w.column<double>(len, [&](size_t i) { return buffer[i].timestamp; });
+    w.column<double>(len, [&](size_t i) { return buffer[i].service_time; });
+
+    w.column<double>(events.size(), [&](size_t i) { return events[i].time; });
+    w.column<uint64_t>(events.size(), [&](size_t i) { return events[i].order_key; });
+    w.column<int32_t>(events.size(), [&](size_t i) { return events[i].entity; });
+
+    if (batch_means_) {
+        put_batch_means(w, batch_means_->wait);
+        put_batch_means(w, batch_means_->system);
+        put_batch_means(w, batch_means_->buffer);
+        w.put<double>(batch_means_->area);
+        w.put<double>(batch_means_->time);
+    }
+    if (regen_) {
+        const RegenerationSet& r = *regen_;
+        w.put<uint32_t>(r.started ? 1 : 0);
+        for (const RatioStats& rs : r.stats) {
+            w.put<uint64_t>(rs.count);
+            w.put<double>(rs.mean_y);
+            w.put<double>(rs.mean_x);
+            w.put<double>(rs.cyy);
+            w.put<double>(rs.cxx);
+            w.put<double>(rs.cxy);
+        }
+        w.put<double>(r.wait);
+        w.put<double>(r.system);
+        w.put<uint64_t>(r.generated);
+        w.put<uint64_t>(r.rejected);
+        w.put<uint64_t>(r.processed);
+        w.put<double>(r.area);
+        w.put<double>(r.time);
+    }
+    return std::move(w.out);
+}
+
+Engine Engine::restore(const uint8_t* data, size_t size) {
+    Reader r(data, size);
+    char magic[8];
+    for (char& c : magic)
+        c = r.get<char>();
+    check(std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0, "не снимок SMO");
+    const uint32_t version = r.get<uint32_t>();
+    check(version == VERSION, "неподдерживаемая версия " + std::to_string(version));
+    const uint32_t flags = r.get<uint32_t>();
+    check((flags & ~KNOWN_FLAGS) == 0, "неизвестные флаги");
+
+    Config config;
+    config.num_restaurants = r.get<int32_t>();
+    config.num_operators = r.get<int32_t>();
+    config.buffer_cap = r.get<int32_t>();
+    const int32_t len = r.get<int32_t>();
+    config.interval = r.get<double>();
+    config.op_mean = r.get<double>();
+    config.seed = r.get<uint64_t>();
+    config.crn = (flags & FLAG_CRN) != 0;
+    config.antithetic = (flags & FLAG_ANTITHETIC) != 0;
+
+    // остаток заголовка читается до конструктора: битые размеры не должны
+    // заставить построить модель на миллиарды операторов
+    const double time = r.get<double>();
+    const double last_event_time = r.get<double>();
+    const double buffer_area = r.get<double>();
+    const double stats_start = r.get<double>();
+    const uint64_t total_generated = r.get<uint64_t>();
+    const uint64_t total_processed = r.get<uint64_t>();
+    const uint64_t total_rejected = r.get<uint64_t>();
+    const uint64_t next_seq = r.get<uint64_t>();
+    r.get<uint64_t>();
+    r.get<uint64_t>();
+    const uint64_t num_events = r.get<uint64_t>();
+    const auto n = static_cast<uint64_t>(config.num_restaurants);
+    const auto m = static_cast<uint64_t>(config.num_operators);
+    check(config.num_restaurants >= 0 && config.num_operators >= 0 && len >= 0 && len <= config.buffer_cap
+              && num_events >= n && num_events <= n + m,
+          "неверные размеры модели");
+    check(config.interval > 0.0 && std::isfinite(config.interval) && config.op_mean > 0.0
+              && std::isfinite(config.op_mean),
+          "неверные параметры модели");
+    check(0.0 <= stats_start && stats_start <= last_event_time && last_event_time <= time && std::isfinite(time),
+          "неверное модельное время");
+    check(next_seq <= SEQ_MASK, "неверный счётчик событий");
+    check(r.remaining() >= n * RESTAURANT_ROW + m * OPERATOR_ROW + static_cast<uint64_t>(len) * ORDER_ROW
+                               + num_events * EVENT_ROW,
+          "обрезан");
+
+    // конструктор строит потоки по seed; состояние ниже заменяет остальное
+    Engine e(config);
+    e.events_.clear();
+    e.time_ = time;
+    e.last_event_time_ = last_event_time;
+    e.buffer_area_ = buffer_area;
+    e.stats_start_ = stats_start;
+    e.total_generated_ = total_generated;
+    e.total_processed_ = total_processed;
+    e.total_rejected_ = total_rejected;
+    e.next_seq_ = next_seq;
+
+    // ожидающее поступление ресторана уже учтено в generated (schedule_arrival),
+    // так что у каждого ресторана generated >= 1
+    r.column<int64_t>(n, [&](size_t i, int64_t v) {
+        check(v >= 1, "неверные счётчики ресторанов");
+        e.restaurants_[i].generated = v;
+    });
+    r.column<int64_t>(n, [&](size_t i, int64_t v) {
+        check(v >= 0 && v <= e.restaurants_[i].generated, "неверные счётчики ресторанов");
+        e.restaurants_[i].generated_base = v;
+    });
+    r.column<double>(n, [&](size_t i, double v) {
+        check(v >= time && std::isfinite(v), "неверные счётчики ресторанов");
+        e.restaurants_[i].next_time = v;
+    });
+    r.column<uint64_t>(n, [&](size_t i, uint64_t v) { e.stats_[i].rejected = v; });
+    // каждое значение потока берётся вместе с планированием события (заказ
+    // с crn — при поступлении, оператор — при начале обслуживания), так что
+    // всего выдано не больше next_seq; иначе seek догонял бы позицию часами
+    uint64_t drawn = 0;
+    auto check_drawn = [&](uint64_t v) {
+        check(v <= next_seq - drawn, "неверные позиции потоков");
+        drawn += v;
+    };
+    r.column<uint64_t>(n, [&](size_t i, uint64_t v) {
+        check_drawn(v);
+        if (config.crn)
+            e.order_service_[i].seek(v);
+    });
+    get_stats(r, e.stats_, &RestaurantStats::wait);
+    get_stats(r, e.stats_, &RestaurantStats::system);
+
+    r.column<uint8_t>(m, [&](size_t i, uint8_t v) {
+        check(v <= 1, "неверное состояние оператора");
+        e.operators_[i].busy = v != 0;
+        if (v)
+            e.free_bits_[i / 64] &= ~(uint64_t{1} << (i % 64));
+    });
+    r.column<int32_t>(m, [&](size_t i, int32_t v) {
+        check(v >= -1 && v < config.num_restaurants, "неверное состояние оператора");
+        e.operators_[i].batch_restaurant_id = v;
+    });
+    r.column<double>(m, [&](size_t i, double v) { e.operators_[i].busy_time = v; });
+    r.column<double>(m, [&](size_t i, double v) { e.operators_[i].last_start_time = v; });
+    r.column<double>(m, [&](size_t i, double v) { e.operators_[i].wait_time = v; });
+    r.column<uint64_t>(m, [&](size_t i, uint64_t v) {
+        check_drawn(v);
+        e.operators_[i].stream.seek(v);
+    });
+    r.column<int32_t>(m, [&](size_t i, int32_t v) {
+        check(!e.operators_[i].busy || (v >= 0 && v < config.num_restaurants), "неверный заказ оператора");
+        e.operators_[i].current_order.restaurant_id = v;
+    });
+    r.column<int64_t>(m, [&](size_t i, int64_t v) { e.operators_[i].current_order.order_id = v; });
+    r.column<double>(m, [&](size_t i, double v) { e.operators_[i].current_order.timestamp = v; });
+    r.column<double>(m, [&](size_t i, double v) { e.operators_[i].current_order.service_time = v; });
+
+    std::vector<Order> buffer(static_cast<size_t>(len));
+    r.column<int32_t>(buffer.size(), [&](size_t i, int32_t v) {
+        check(v >= 0 && v < config.num_restaurants, "неверный заказ в буфере");
+        buffer[i].restaurant_id = v;
+    });
+    r.column<int64_t>(buffer.size(), [&](size_t i, int64_t v) { buffer[i].order_id = v; });
+    r.column<double>(buffer.size(), [&](size_t i, double v) { buffer[i].timestamp = v; });
+    r.column<double>(buffer.size(), [&](size_t i, double v) { buffer[i].service_time = v; });
+    for (const Order& order : buffer)
+        e.buffer_.push(order);
+
+    std::vector<Event> events(num_events);
+    r.column<double>(events.size(), [&](size_t i, double v) { events[i].time = v; });
+    r.column<uint64_t>(events.size(), [&](size_t i, uint64_t v) { events[i].order_key = v; });
+    r.column<int32_t>(events.size(), [&](size_t i, int32_t v) { events[i].entity = v; });
+    // у каждого ресторана ровно одно ожидающее поступление, у каждого
+    // занятого оператора — одно завершение
+    std::vector<uint32_t> pending(n), finishing(m);
+    for (const Event& ev : events) {
+        check((ev.order_key & SEQ_MASK) < next_seq && ev.time >= time && std::isfinite(ev.time),
+              "неверное событие");
+        if (ev.prio() == PRIO_ARRIVAL && ev.entity >= 0 && ev.entity < config.num_restaurants) {
+            pending[static_cast<size_t>(ev.entity)] += 1;
+        } else if (ev.prio() == PRIO_COMPLETION && ev.entity >= 0 && ev.entity < config.num_operators
+                   && e.operators_[static_cast<size_t>(ev.entity)].busy) {
+            finishing[static_cast<size_t>(ev.entity)] += 1;
+        } else {
+            check(false, "неверное событие");
+        }
+        e.events_.push(ev);
+    }
+    for (size_t i = 0; i < n; ++i)
+        check(pending[i] == 1, "неверный календарь событий");
+    for (size_t i = 0; i < m; ++i)
+        check(finishing[i] == (e.operators_[i].busy ? 1U : 0U), "неверный календарь событий");
+
+    if (flags & FLAG_BATCH_MEANS) {
+        BatchMeans wait = get_batch_means(r);
+        BatchMeans system = get_batch_means(r);
+        BatchMeans buffer = get_batch_means(r);
+        e.batch_means_max_ = wait.max_batches();
+        e.batch_means_ = std::make_unique<BatchMeansSet>(e.batch_means_max_, 0.0, 0.0);
+        e.batch_means_->wait = std::move(wait);
+        e.batch_means_->system = std::move(system);
+        e.batch_means_->buffer = std::move(buffer);
+        e.batch_means_->area = r.get<double>();
+        e.batch_means_->time = r.get<double>();
+    }
+    if (flags & FLAG_REGENERATIVE) {
+        e.regen_ = std::make_unique<RegenerationSet>();
+        RegenerationSet& g = *e.regen_;
+        g.started = r.get<uint32_t>() != 0;
+        for (RatioStats& rs : g.stats) {
+            rs.count = r.get<uint64_t>();
+            rs.mean_y = r.get<double>();
+            rs.mean_x = r.get<double>();
+            rs.cyy = r.get<double>();
+            rs.cxx = r.get<double>();
+            rs.cxy = r.get<double>();
+        }
+        g.wait = r.get<double>();
+        g.system = r.get<double>();
+        g.generated = r.get<uint64_t>();
+        g.rejected = r.get<uint64_t>();
+        g.processed = r.get<uint64_t>();
+        g.area = r.get<double>();
+        g.time = r.get<double>();
+    }
+    check(r.done(), "лишние данные в конце");
+    return e;
+}
+
+}  // namespace smo
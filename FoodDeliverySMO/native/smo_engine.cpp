@@ -0,0 +1,295 @@
+#include "smo_engine.h"
+
+#include <algorithm>
+
+namespace smo {
+
+Engine::Engine(const Config& config)
+    : config_(config) {
+    const RandomStream operator_streams(split_key(config.seed, STREAM_OPERATOR), StreamKind::EXPONENTIAL,
+                                        config.antithetic);
+    operators_.resize(static_cast<size_t>(config.num_operators));
+    for (size_t i = 0; i < operators_.size(); ++i) {
+        operators_[i].mean_service_time = config.op_mean;
+        operators_[i].rate = 1.0 / config.op_mean;
+        operators_[i].stream = operator_streams.split(i);
+    }
+    free_bits_.assign((operators_.size() + 63) / 64, 0);
+    for (size_t i = 0; i < operators_.size(); ++i)
+        free_bits_[i / 64] |= uint64_t{1} << (i % 64);
+
+    restaurants_.reserve(static_cast<size_t>(config.num_restaurants));
+    for (int i = 0; i < config.num_restaurants; ++i) {
+        double start_offset = (i * config.interval) / config.num_restaurants;
+        restaurants_.push_back(RestaurantSource{config.interval, start_offset});
+    }
+    stats_.resize(restaurants_.size());
+    if (config.crn) {
+        const RandomStream restaurant_streams(split_key(config.seed, STREAM_RESTAURANT), StreamKind::EXPONENTIAL,
+                                              config.antithetic);
+        for (int i = 0; i < config.num_restaurants; ++i)
+            order_service_.push_back(restaurant_streams.split(static_cast<uint64_t>(i)));
+        order_rate_ = 1.0 / config.op_mean;
+    }
+    buffer_.reset(restaurants_.size());
+
+    for (int32_t i = 0; i < config.num_restaurants; ++i)
+        schedule_arrival(i);
+}
+
+void Engine::push_event(const Event& ev) {
+    if (top_consumed_) {
+        top_consumed_ = false;
+        events_.replace_top(ev);
+    } else {
+        events_.push(ev);
+    }
+}
+
+// RestaurantSource.generate_event + push_event
+void Engine::schedule_arrival(int32_t restaurant_id) {
+    RestaurantSource& src = restaurants_[restaurant_id];
+    Event ev{};
+    ev.time = src.next_time;
+    ev.order_key = make_order_key(PRIO_ARRIVAL, next_seq_++);
+    ev.entity = restaurant_id;
+    src.generated += 1;
+    src.next_time += src.interval;
+    push_event(ev);
+}
+
+// Потоки засеваются лениво, но группами по SEED_GROUP соседних номеров:
+// первое обращение к потоку засевает всю его группу вперемешку
+// (RandomStream::seed_many). Свободного оператора берут с наименьшим
+// номером, так что соседи идут в работу вместе, а засев группы стоит
+// втрое меньше, чем засев тех же потоков по одному.
+constexpr size_t SEED_GROUP = 8;
+
+template <class StreamAt>
+static void seed_stream_group(size_t index, size_t count, StreamAt stream_at) {
+    RandomStream* streams[SEED_GROUP];
+    size_t n = 0;
+    const size_t first = index - index % SEED_GROUP;
+    for (size_t i = first; i < std::min(count, first + SEED_GROUP); ++i) {
+        RandomStream& s = stream_at(i);
+        if (!s.seeded())
+            streams[n++] = &s;
+    }
+    RandomStream::seed_many(streams, n);
+}
+
+void Engine::seed_operator_streams(int32_t operator_id) {
+    seed_stream_group(static_cast<size_t>(operator_id), operators_.size(),
+                      [this](size_t i) -> RandomStream& { return operators_[i].stream; });
+}
+
+void Engine::seed_order_streams(int32_t restaurant_id) {
+    seed_stream_group(static_cast<size_t>(restaurant_id), order_service_.size(),
+                      [this](size_t i) -> RandomStream& { return order_service_[i]; });
+}
+
+// Operator.start_service + push_event
+void Engine::start_service(int32_t operator_id, const Order& order) {
+    Operator& op = operators_[operator_id];
+    if (order.service_time < 0.0 && !op.stream.seeded())
+        seed_operator_streams(operator_id);
+    op.busy = true;
+    op.current_order = order;
+    op.batch_restaurant_id = order.restaurant_id;
+    op.last_start_time = time_;
+    op.wait_time = time_ - order.timestamp;   // Event.wait_time в Operator.start_service
+    free_bits_[operator_id / 64] &= ~(uint64_t{1} << (operator_id % 64));
+
+    // П32: Exp(1) из блока потока, масштабированное как в random.expovariate
+    double dt = order.service_time >= 0.0 ? order.service_time : op.stream.next() / op.rate;
+    Event ev{};
+    ev.time = time_ + dt;
+    ev.order_key = make_order_key(PRIO_COMPLETION, next_seq_++);
+    ev.entity = operator_id;
+    push_event(ev);
+}
+
+// Operator.free
+void Engine::free_operator(int32_t operator_id) {
+    Operator& op = operators_[operator_id];
+    op.busy_time += (time_ - op.last_start_time);
+    op.busy = false;
+    free_bits_[operator_id / 64] |= uint64_t{1} << (operator_id % 64);
+}
+
+int32_t Engine::free_operator_d2p1() const {
+    for (size_t w = 0; w < free_bits_.size(); ++w) {
+        if (free_bits_[w])
+            return static_cast<int32_t>(w * 64 + std::countr_zero(free_bits_[w]));
+    }
+    return -1;
+}
+
+bool Engine::take_order_from_buffer_d2b5(Operator& op, Order& out) {
+    if (buffer_.empty())
+        return false;
+    if (op.batch_restaurant_id >= 0 && buffer_.pop_first(op.batch_restaurant_id, out))
+        return true;
+    op.batch_restaurant_id = buffer_.min_restaurant();
+    return buffer_.pop_first(op.batch_restaurant_id, out);
+}
+
+bool Engine::step() {
+    if (events_.empty())
+        return false;
+
+    const Event ev = events_.top();
+    top_consumed_ = true;
+
+    double dt = ev.time - last_event_time_;
+    if (dt > 0) {
+        buffer_area_ += static_cast<double>(buffer_.size()) * dt;
+        last_event_time_ = ev.time;
+    }
+    time_ = ev.time;
+
+    if (ev.prio() == PRIO_ARRIVAL) {
+        total_generated_ += 1;
+        const int32_t restaurant_id = ev.entity;
+        // RegenerationSource: поступление ресторана 0 в пустую систему
+        if (regen_ && restaurant_id == 0 && buffer_.empty() && all_operators_free())
+            regenerate();
+        // ожидающее поступление ресторана всегда одно — последнее запланированное
+        Order order{restaurant_id, restaurants_[restaurant_id].generated - 1, ev.time};
+        if (config_.crn) {
+            if (!order_service_[restaurant_id].seeded())
+                seed_order_streams(restaurant_id);
+            order.service_time = order_service_[restaurant_id].next() / order_rate_;
+        }
+        schedule_arrival(restaurant_id);
+
+        int32_t op = free_operator_d2p1();
+        if (op >= 0) {
+            start_service(op, order);
+        } else if (buffer_.size() < static_cast<size_t>(config_.buffer_cap)) {
+            buffer_.push(order);
+        } else {
+            total_rejected_ += 1;
+            stats_[order.restaurant_id].rejected += 1;
+        }
+    } else {
+        const int32_t operator_id = ev.entity;
+        Operator& op = operators_[operator_id];
+
+        const Order& finished = op.current_order;
+        double system_time = time_ - finished.timestamp;
+        double wait_time = op.wait_time;
+        RestaurantStats& rs = stats_[finished.restaurant_id];
+        rs.system.add(system_time);
+        if (regen_)
+            regen_->system += system_time;
+        if (batch_means_) {
+            BatchMeansSet& bm = *batch_means_;
+            bm.system.add(system_time);
+            bm.buffer.add(buffer_area_ - bm.area, time_ - bm.time);
+            bm.area = buffer_area_;
+            bm.time = time_;
+        }
+
+        free_operator(operator_id);
+
+        total_processed_ += 1;
+        rs.wait.add(wait_time);
+        if (batch_means_)
+            batch_means_->wait.add(wait_time);
+        if (regen_)
+            regen_->wait += wait_time;
+
+        Order order;
+        if (take_order_from_buffer_d2b5(op, order))
+            start_service(operator_id, order);
+    }
+
+    if (top_consumed_) {
+        top_consumed_ = false;
+        events_.pop();
+    }
+    return true;
+}
+
+void Engine::reset_statistics() {
+    stats_start_ = time_;
+    total_generated_ = 0;
+    total_processed_ = 0;
+    total_rejected_ = 0;
+    for (RestaurantSource& src : restaurants_)
+        src.generated_base = src.generated;
+    stats_.assign(restaurants_.size(), RestaurantStats{});
+    buffer_area_ = 0.0;
+    last_event_time_ = time_;
+    for (Operator& op : operators_) {
+        op.busy_time = 0.0;
+        if (op.busy)
+            op.last_start_time = time_;
+    }
+    if (batch_means_)
+        enable_batch_means(batch_means_max_);
+    if (regen_)
+        enable_regenerative();
+}
+
+void Engine::enable_regenerative() {
+    regen_ = std::make_unique<RegenerationSet>();
+}
+
+bool Engine::all_operators_free() const {
+    const size_t n = operators_.size();
+    for (size_t w = 0; w < free_bits_.size(); ++w) {
+        const size_t bits = std::min<size_t>(64, n - w * 64);
+        const uint64_t all = bits == 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+        if (free_bits_[w] != all)
+            return false;
+    }
+    return true;
+}
+
+// RegenerativeCollector.regenerate: само поступление (уже в total_generated_)
+// открывает новый цикл
+void Engine::regenerate() {
+    RegenerationSet& r = *regen_;
+    const uint64_t generated = total_generated_ - 1;
+    if (r.started) {
+        const double tau = time_ - r.time;
+        const double processed = static_cast<double>(total_processed_ - r.processed);
+        r.stats[0].add(static_cast<double>(total_rejected_ - r.rejected),
+                       static_cast<double>(generated - r.generated));
+        r.stats[1].add(r.wait, processed);
+        r.stats[2].add(r.system, processed);
+        r.stats[3].add(r.system - r.wait, static_cast<double>(operators_.size()) * tau);
+        r.stats[4].add(buffer_area_ - r.area, tau);
+    }
+    r.started = true;
+    r.wait = 0.0;
+    r.system = 0.0;
+    r.generated = generated;
+    r.rejected = total_rejected_;
+    r.processed = total_processed_;
+    r.area = buffer_area_;
+    r.time = time_;
+}
+
+void Engine::enable_batch_means(int max_batches) {
+    batch_means_max_ = max_batches;
+    batch_means_ = std::make_unique<BatchMeansSet>(max_batches, buffer_area_, time_);
+}
+
+uint64_t Engine::run_until(double t_max, uint64_t max_events) {
+    uint64_t events = 0;
+    while (events < max_events && time_ < t_max && step())
+        ++events;
+    return events;
+}
+
+uint64_t Engine::run_until(double t_max) {
+    uint64_t events = 0;
+    while (time_ < t_max && step())
+        ++events;
+    return events;
+}
+
+}  // namespace smo
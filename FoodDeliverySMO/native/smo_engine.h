@@ -0,0 +1,461 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "random_stream.h"
+
+namespace smo {
+
+struct Config {
+    int num_restaurants = 15;
+    int num_operators = 50;
+    double interval = 0.2;
+    double op_mean = 2.0;
+    int buffer_cap = 100;
+    uint64_t seed = 1;
+    bool crn = false;          // SMO(crn=True): времена обслуживания по заказам
+    bool antithetic = false;   // SMO(antithetic=True)
+};
+
+// Приоритеты одновременных событий — как PRIO_COMPLETION/PRIO_ARRIVAL в SMO
+enum EventPriority : int {
+    PRIO_COMPLETION = 0,
+    PRIO_ARRIVAL = 1,
+};
+
+// Событие хранит только ключ и номер сущности: ресторана для поступления,
+// оператора для завершения. Номер заказа и ожидание восстанавливаются из
+// состояния источника/оператора, поэтому запись занимает 24 байта.
+struct Event {
+    double time;
+    uint64_t order_key;   // (priority << 62) | seq — вторая и третья позиции ключа SMO
+    int32_t entity;
+
+    int prio() const { return static_cast<int>(order_key >> 62); }
+};
+
+inline uint64_t make_order_key(int prio, uint64_t seq) {
+    return (static_cast<uint64_t>(prio) << 62) | seq;
+}
+
+// Порядок кортежа (time, priority, seq) из SMO.push_event
+inline bool event_before(const Event& a, const Event& b) {
+    if (a.time != b.time)
+        return a.time < b.time;
+    return a.order_key < b.order_key;
+}
+
+// 4-арная min-куча событий: вдвое меньше уровней, чем у бинарной, а четыре
+// сына лежат в одной-двух строках кэша — при сотнях операторов просейка
+// была главной статьёй расхода. Ключи событий различны, так что порядок
+// извлечения тот же, что у heapq в SMO. replace_top заменяет вершину одной
+// просейкой: в step() извлечённое событие почти всегда сразу сменяется
+// следующим событием того же источника, и pop+push превращается в одну
+// операцию.
+class EventHeap {
+public:
+    bool empty() const { return heap_.empty(); }
+    size_t size() const { return heap_.size(); }
+    const Event& top() const { return heap_.front(); }
+
+    void push(const Event& ev) {
+        heap_.push_back(ev);
+        sift_up(heap_.size() - 1);
+    }
+
+    void pop() {
+        heap_.front() = heap_.back();
+        heap_.pop_back();
+        if (!heap_.empty())
+            sift_down(0);
+    }
+
+    void replace_top(const Event& ev) {
+        heap_.front() = ev;
+        sift_down(0);
+    }
+
+    // для снимка состояния: события в порядке кучи
+    const std::vector<Event>& items() const { return heap_; }
+    void clear() { heap_.clear(); }
+
+private:
+    static constexpr size_t ARITY = 4;
+
+    void sift_up(size_t pos) {
+        Event ev = heap_[pos];
+        while (pos > 0) {
+            size_t parent = (pos - 1) / ARITY;
+            if (!event_before(ev, heap_[parent]))
+                break;
+            heap_[pos] = heap_[parent];
+            pos = parent;
+        }
+        heap_[pos] = ev;
+    }
+
+    void sift_down(size_t pos) {
+        const size_t size = heap_.size();
+        Event ev = heap_[pos];
+        for (;;) {
+            const size_t first = ARITY * pos + 1;
+            if (first >= size)
+                break;
+            const size_t last = std::min(first + ARITY, size);
+            size_t child = first;
+            for (size_t c = first + 1; c < last; ++c) {
+                if (event_before(heap_[c], heap_[child]))
+                    child = c;
+            }
+            if (!event_before(heap_[child], ev))
+                break;
+            heap_[pos] = heap_[child];
+            pos = child;
+        }
+        heap_[pos] = ev;
+    }
+
+    std::vector<Event> heap_;
+};
+
+struct Order {
+    int32_t restaurant_id;
+    int64_t order_id;
+    double timestamp;
+    double service_time = -1.0;   // < 0 — None в SMO: разыгрывает оператор
+};
+
+// Буфер Д1ОЗ2 с индексом по ресторанам для Д2Б5: у каждого ресторана своя
+// FIFO-цепочка заказов в общем пуле ячеек, непустые рестораны отмечены
+// битами. Заказ ресторана пакета и ресторан с минимальным номером находятся
+// без просмотра всего буфера; общий порядок поступления нужен только снимку
+// и восстанавливается по номерам вставки.
+class OrderBuffer {
+public:
+    void reset(size_t num_restaurants) {
+        slots_.clear();
+        free_ = -1;
+        head_.assign(num_restaurants, -1);
+        tail_.assign(num_restaurants, -1);
+        nonempty_bits_.assign((num_restaurants + 63) / 64, 0);
+        size_ = 0;
+        next_seq_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void push(const Order& order) {
+        int32_t slot = free_;
+        if (slot >= 0) {
+            free_ = slots_[slot].next;
+        } else {
+            slot = static_cast<int32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+        slots_[slot] = Slot{order, next_seq_++, -1};
+        const int32_t rid = order.restaurant_id;
+        if (tail_[rid] >= 0) {
+            slots_[tail_[rid]].next = slot;
+        } else {
+            head_[rid] = slot;
+            nonempty_bits_[rid / 64] |= uint64_t{1} << (rid % 64);
+        }
+        tail_[rid] = slot;
+        ++size_;
+    }
+
+    // первый заказ ресторана (SMO._pop_first_by_restaurant)
+    bool pop_first(int32_t restaurant_id, Order& out) {
+        const int32_t slot = head_[restaurant_id];
+        if (slot < 0)
+            return false;
+        out = slots_[slot].order;
+        head_[restaurant_id] = slots_[slot].next;
+        if (head_[restaurant_id] < 0) {
+            tail_[restaurant_id] = -1;
+            nonempty_bits_[restaurant_id / 64] &= ~(uint64_t{1} << (restaurant_id % 64));
+        }
+        slots_[slot].next = free_;
+        free_ = slot;
+        --size_;
+        return true;
+    }
+
+    // минимальный номер ресторана среди заказов буфера, -1 — буфер пуст
+    int32_t min_restaurant() const {
+        for (size_t w = 0; w < nonempty_bits_.size(); ++w) {
+            if (nonempty_bits_[w])
+                return static_cast<int32_t>(w * 64 + std::countr_zero(nonempty_bits_[w]));
+        }
+        return -1;
+    }
+
+    // заказы в порядке поступления (для снимка)
+    std::vector<Order> orders() const {
+        std::vector<std::pair<uint64_t, int32_t>> live;
+        live.reserve(size_);
+        for (int32_t head : head_) {
+            for (int32_t slot = head; slot >= 0; slot = slots_[slot].next)
+                live.emplace_back(slots_[slot].seq, slot);
+        }
+        std::sort(live.begin(), live.end());
+        std::vector<Order> out;
+        out.reserve(live.size());
+        for (const auto& [seq, slot] : live)
+            out.push_back(slots_[slot].order);
+        return out;
+    }
+
+private:
+    struct Slot {
+        Order order;
+        uint64_t seq;    // номер вставки — порядок поступления в буфер
+        int32_t next;    // следующий заказ ресторана или свободная ячейка
+    };
+
+    std::vector<Slot> slots_;
+    int32_t free_ = -1;
+    std::vector<int32_t> head_;
+    std::vector<int32_t> tail_;
+    std::vector<uint64_t> nonempty_bits_;
+    size_t size_ = 0;
+    uint64_t next_seq_ = 0;
+};
+
+struct RestaurantSource {
+    double interval;
+    double next_time;
+    int64_t generated = 0;
+    int64_t generated_base = 0;   // generated на момент reset_statistics
+};
+
+struct Operator {
+    double mean_service_time;
+    double rate;          // 1 / mean_service_time, как Operator._rate
+    RandomStream stream;  // StreamKind::EXPONENTIAL: Exp(1) для П32
+    bool busy = false;
+    Order current_order{};
+    int32_t batch_restaurant_id = -1;   // -1 — None в SMO
+    double busy_time = 0.0;
+    double last_start_time = 0.0;
+    double wait_time = 0.0;   // Event.wait_time текущего заказа в SMO
+};
+
+// Потоковая статистика по Уэлфорду — те же операции, что RunningStats.add в SMO
+struct RunningStats {
+    uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void add(double x) {
+        count += 1;
+        double delta = x - mean;
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (x - mean);
+        if (x < min)
+            min = x;
+        if (x > max)
+            max = x;
+    }
+};
+
+// Пакетные средние за O(max_batches) памяти — BatchMeans из SMO: пакет
+// закрывается по достижении веса size, при max_batches полных пакетах
+// соседние пары сливаются и size удваивается.
+class BatchMeans {
+public:
+    explicit BatchMeans(int max_batches = 64, double size = 1.0)
+        : max_batches_(max_batches), size_(size) {
+        sums_.reserve(static_cast<size_t>(max_batches));
+        weights_.reserve(static_cast<size_t>(max_batches));
+    }
+
+    void add(double total, double weight = 1.0) {
+        sum_ += total;
+        weight_ += weight;
+        if (weight_ < size_)
+            return;
+        sums_.push_back(sum_);
+        weights_.push_back(weight_);
+        sum_ = 0.0;
+        weight_ = 0.0;
+        if (static_cast<int>(sums_.size()) == max_batches_) {
+            const size_t half = sums_.size() / 2;
+            for (size_t i = 0; i < half; ++i) {
+                sums_[i] = sums_[2 * i] + sums_[2 * i + 1];
+                weights_[i] = weights_[2 * i] + weights_[2 * i + 1];
+            }
+            sums_.resize(half);
+            weights_.resize(half);
+            size_ *= 2;
+        }
+    }
+
+    // восстановление из снимка (smo_checkpoint.cpp)
+    void set_state(double size, std::vector<double> sums, std::vector<double> weights,
+                   double partial_sum, double partial_weight) {
+        size_ = size;
+        sums_ = std::move(sums);
+        weights_ = std::move(weights);
+        sum_ = partial_sum;
+        weight_ = partial_weight;
+    }
+
+    int max_batches() const { return max_batches_; }
+    const std::vector<double>& sums() const { return sums_; }
+    const std::vector<double>& weights() const { return weights_; }
+    double size() const { return size_; }
+    double partial_sum() const { return sum_; }
+    double partial_weight() const { return weight_; }
+
+private:
+    int max_batches_;
+    double size_;
+    std::vector<double> sums_;
+    std::vector<double> weights_;
+    double sum_ = 0.0;
+    double weight_ = 0.0;
+};
+
+// BatchMeansCollector из SMO: ожидание и пребывание по заказам, длина
+// буфера — по интервалам между завершениями
+struct BatchMeansSet {
+    BatchMeans wait;
+    BatchMeans system;
+    BatchMeans buffer;
+    double area = 0.0;   // buffer_area на последнем завершении
+    double time = 0.0;
+
+    BatchMeansSet(int max_batches, double area0, double time0)
+        : wait(max_batches), system(max_batches), buffer(max_batches), area(area0), time(time0) {}
+};
+
+// Средние и ковариации пары (Y, X) по циклам регенерации — RatioStats из SMO
+struct RatioStats {
+    uint64_t count = 0;
+    double mean_y = 0.0;
+    double mean_x = 0.0;
+    double cyy = 0.0;
+    double cxx = 0.0;
+    double cxy = 0.0;
+
+    void add(double y, double x) {
+        count += 1;
+        double dy = y - mean_y;
+        double dx = x - mean_x;
+        mean_y += dy / static_cast<double>(count);
+        mean_x += dx / static_cast<double>(count);
+        cyy += dy * (y - mean_y);
+        cxx += dx * (x - mean_x);
+        cxy += dx * (y - mean_y);
+    }
+};
+
+// RegenerativeCollector из SMO: отношения в порядке REGENERATIVE_METRICS
+// (p_reject, wait_mean, system_mean, utilization, buffer_mean) и суммы
+// текущего цикла
+struct RegenerationSet {
+    static constexpr int METRICS = 5;
+    RatioStats stats[METRICS];
+    bool started = false;
+    double wait = 0.0;
+    double system = 0.0;
+    uint64_t generated = 0;
+    uint64_t rejected = 0;
+    uint64_t processed = 0;
+    double area = 0.0;
+    double time = 0.0;
+};
+
+struct RestaurantStats {
+    uint64_t rejected = 0;
+    RunningStats wait;
+    RunningStats system;
+};
+
+// Нативная реализация SMO.step: Д1ОЗ2 (FIFO-буфер), Д1ОО5 (отказ новой
+// заявки), Д2П1 (свободный оператор с минимальным номером), Д2Б5 (пакет по
+// ресторану) и П32 (экспоненциальное обслуживание). Порядок событий, число
+// обращений к генератору и арифметика совпадают с Python-версией.
+class Engine {
+public:
+    explicit Engine(const Config& config);
+
+    bool step();
+    uint64_t run_until(double t_max);
+    // то же, но не больше max_events событий (прогон между снимками)
+    uint64_t run_until(double t_max, uint64_t max_events);
+    // SMO.reset_statistics: статистика копится заново с текущего момента
+    void reset_statistics();
+    // SMO(batch_means=True): включать сразу после создания
+    void enable_batch_means(int max_batches);
+    const BatchMeansSet* batch_means() const { return batch_means_.get(); }
+    // SMO(regenerative=True): включать сразу после создания
+    void enable_regenerative();
+    const RegenerationSet* regenerative() const { return regen_.get(); }
+
+    // Снимок полного состояния в формате smo_checkpoint.py (см. smo_checkpoint.cpp);
+    // restore бросает std::invalid_argument на повреждённых данных
+    std::vector<uint8_t> checkpoint() const;
+    static Engine restore(const uint8_t* data, size_t size);
+
+    double time() const { return time_; }
+    double stats_start() const { return stats_start_; }
+    double buffer_area() const { return buffer_area_; }
+    uint64_t total_generated() const { return total_generated_; }
+    uint64_t total_processed() const { return total_processed_; }
+    uint64_t total_rejected() const { return total_rejected_; }
+    size_t buffer_length() const { return buffer_.size(); }
+
+    const std::vector<RestaurantSource>& restaurants() const { return restaurants_; }
+    const std::vector<Operator>& operators() const { return operators_; }
+    const std::vector<RestaurantStats>& restaurant_stats() const { return stats_; }
+
+private:
+    void push_event(const Event& ev);
+    void schedule_arrival(int32_t restaurant_id);
+    void start_service(int32_t operator_id, const Order& order);
+    void seed_operator_streams(int32_t operator_id);
+    void seed_order_streams(int32_t restaurant_id);
+    void free_operator(int32_t operator_id);
+    int32_t free_operator_d2p1() const;
+    bool all_operators_free() const;
+    void regenerate();
+    bool take_order_from_buffer_d2b5(Operator& op, Order& out);
+
+    Config config_;
+
+    double time_ = 0.0;
+    double last_event_time_ = 0.0;
+    double buffer_area_ = 0.0;
+    double stats_start_ = 0.0;
+    uint64_t next_seq_ = 0;
+
+    EventHeap events_;
+    bool top_consumed_ = false;   // вершина уже обработана в step(), но ещё не удалена
+    OrderBuffer buffer_;
+    std::vector<RestaurantSource> restaurants_;
+    std::vector<Operator> operators_;
+    std::vector<uint64_t> free_bits_;   // бит i — оператор i свободен
+    std::vector<RandomStream> order_service_;   // crn: поток ресторана i
+    double order_rate_ = 1.0;
+
+    uint64_t total_generated_ = 0;
+    uint64_t total_processed_ = 0;
+    uint64_t total_rejected_ = 0;
+    std::vector<RestaurantStats> stats_;
+    std::unique_ptr<BatchMeansSet> batch_means_;
+    int batch_means_max_ = 0;
+    std::unique_ptr<RegenerationSet> regen_;
+};
+
+}  // namespace smo
@@ -0,0 +1,200 @@
+import argparse
+import csv
+import hashlib
+import inspect
+import json
+import random
+import sys
+import time
+from typing import Dict, Iterator, List, Optional
+
+from smo_food_center import SMO
+from smo_replications import METRICS, make_model, metrics_from_summary, replication_seed
+from smo_warmup import run_with_warmup
+
+
+# Параметры конструктора SMO, которые можно задать в сценарии; журнал и
+# трассировка в пакетном режиме не нужны (прогон идёт с TraceLevel.OFF).
+MODEL_PARAMS = ("num_restaurants", "num_operators", "interval", "op_mean", "buffer_cap", "event_set",
+                "crn", "antithetic")
+NATIVE_PARAMS = ("num_restaurants", "num_operators", "interval", "op_mean", "buffer_cap",
+                 "crn", "antithetic")
+MODEL_DEFAULTS = {name: p.default for name, p in inspect.signature(SMO).parameters.items()
+                  if name in MODEL_PARAMS}
+
+# Ключи одного прогона в сценарии
+RUN_KEYS = ("name", "t_max", "seed", "replications", "backend", "warmup", "params")
+
+# Поля записи результата в порядке столбцов CSV
+RECORD_FIELDS = (
+    ("job_id", "name", "run", "replication", "backend", "seed", "t_max")
+    + MODEL_PARAMS
+    + ("warmup", "events", "wall_time", "time", "total_generated", "total_processed", "total_rejected")
+    + tuple(METRICS)
+)
+
+
+def load_scenario(path: str) -> dict:
+    # JSON или TOML по расширению файла
+    if path.endswith(".toml"):
+        import tomllib
+        with open(path, "rb") as f:
+            return tomllib.load(f)
+    with open(path, encoding="utf-8") as f:
+        return json.load(f)
+
+
+def expand_runs(scenario) -> List[dict]:
+    # Сценарий — один прогон или общие настройки верхнего уровня + список
+    # runs; params прогона дополняют общие params. Каждая репликация
+    # становится отдельным заданием со своим seed.
+    if isinstance(scenario, list):
+        scenario = {"runs": scenario}
+    defaults = {k: v for k, v in scenario.items() if k != "runs"}
+    runs = scenario.get("runs") or [{}]
+
+    jobs = []
+    for index, run in enumerate(runs):
+        unknown = (set(defaults) | set(run)) - set(RUN_KEYS)
+        if unknown:
+            raise ValueError(f"прогон {index}: неизвестные ключи {sorted(unknown)}")
+        spec = {**defaults, **run, "params": {**defaults.get("params", {}), **run.get("params", {})}}
+        if "t_max" not in spec:
+            raise ValueError(f"прогон {index}: не задан горизонт t_max")
+
+        backend = spec.get("backend", "python")
+        if backend not in ("python", "native"):
+            raise ValueError(f"прогон {index}: неизвестный backend {backend!r}")
+        allowed = NATIVE_PARAMS if backend == "native" else MODEL_PARAMS
+        unknown = set(spec["params"]) - set(allowed)
+        if unknown:
+            raise ValueError(f"прогон {index}: параметры {sorted(unknown)} не поддерживаются ({backend})")
+
+        # с replications seeds как в smo_replications.run_replications
+        seed = spec.get("seed", 1)
+        replicated = "replications" in spec
+        if replicated and seed is None:
+            raise ValueError(f"прогон {index}: seed = null несовместим с replications — "
+                             f"ключи репликаций выводятся из базового seed")
+        for r in range(spec.get("replications", 1)):
+            job = {
+                "name": spec.get("name", f"run{index}"),
+                "run": index,
+                "replication": r,
+                "backend": backend,
+                "seed": replication_seed(seed, r) if replicated else seed,
+                "t_max": float(spec["t_max"]),
+                "warmup": bool(spec.get("warmup", False)),
+                "params": spec["params"],
+            }
+            job["job_id"] = job_id(job)
+            jobs.append(job)
+    return jobs
+
+
+def job_id(job: dict) -> str:
+    # Устойчивый идентификатор прогона: модель, горизонт, seed и движок
+    # (имя и номер в сценарии не входят — переименование не меняет прогон)
+    names = NATIVE_PARAMS if job["backend"] == "native" else MODEL_PARAMS
+    params = {k: job["params"].get(k, MODEL_DEFAULTS[k]) for k in names}
+    for k in ("interval", "op_mean"):
+        params[k] = float(params[k])
+    for k in ("crn", "antithetic"):
+        # выключенные флаги не входят в ключ: job_id прежних таблиц не меняется
+        if not params.pop(k):
+            continue
+        params[k] = True
+    key = {k: job[k] for k in ("backend", "seed", "t_max")}
+    key["params"] = params
+    if job["warmup"]:
+        key["warmup"] = True
+    text = json.dumps(key, sort_keys=True)
+    return hashlib.sha1(text.encode("utf-8")).hexdigest()[:16]
+
+
+def run_job(job: dict, full: bool = False) -> dict:
+    # Один прогон без консольного вывода; возвращает плоскую запись результата
+    # (warmup — статистика после разгона по MSER-5, поле warmup = t_w,
+    # events — события пилотного и основного прогонов вместе)
+    params, t_max, backend = job["params"], job["t_max"], job["backend"]
+    seed = job["seed"] if job["seed"] is not None else random.getrandbits(64)
+    start = time.perf_counter()
+    if job["warmup"]:
+        smo, t_w, events = run_with_warmup(lambda: make_model(params, seed, backend), t_max)
+    else:
+        smo = make_model(params, seed, backend)
+        events = smo.run_until(t_max)
+        t_w = None
+    wall_time = time.perf_counter() - start
+
+    s = smo.summary()
+    record = {key: job[key] for key in ("job_id", "name", "run", "replication", "backend", "t_max")}
+    record["seed"] = smo.seed   # фактический ключ, в том числе при seed = None
+    record.update({key: params.get(key, MODEL_DEFAULTS[key]) for key in MODEL_PARAMS})
+    if job["backend"] == "native":
+        record["event_set"] = None
+    record.update(warmup=t_w, events=events, wall_time=wall_time, time=s["time"],
+                  total_generated=s["total_generated"], total_processed=s["total_processed"],
+                  total_rejected=s["total_rejected"])
+    record.update(metrics_from_summary(s))
+    if full:
+        record["summary"] = s
+    return record
+
+
+def run_batch(jobs: List[dict], full: bool = False) -> Iterator[dict]:
+    for job in jobs:
+        yield run_job(job, full)
+
+
+class RecordWriter:
+    # Запись результатов по мере готовности: JSON Lines или CSV
+    # (header=False — дозапись в таблицу, где заголовок уже есть; fields —
+    # её столбцы, если таблица записана с другим набором полей)
+    def __init__(self, stream, fmt: str, header: bool = True, fields: Optional[List[str]] = None):
+        self._stream = stream
+        self._csv: Optional[csv.DictWriter] = None
+        if fmt == "csv":
+            self._csv = csv.DictWriter(stream, fieldnames=fields or RECORD_FIELDS, extrasaction="ignore")
+            if header:
+                self._csv.writeheader()
+
+    def write(self, record: Dict):
+        if self._csv is not None:
+            self._csv.writerow(record)
+        else:
+            self._stream.write(json.dumps(record, ensure_ascii=False) + "\n")
+        self._stream.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Пакетные прогоны SMO по сценарию (JSON/TOML)")
+    parser.add_argument("scenario", help="файл сценария .json или .toml")
+    parser.add_argument("-o", "--output", default="-", help="файл результатов (по умолчанию stdout)")
+    parser.add_argument("--format", choices=("jsonl", "csv"), default=None,
+                        help="формат записей (по умолчанию по расширению, иначе jsonl)")
+    parser.add_argument("--full", action="store_true",
+                        help="добавить в JSON-запись полную summary() по ресторанам и операторам")
+    args = parser.parse_args()
+
+    fmt = args.format or ("csv" if args.output.endswith(".csv") else "jsonl")
+    try:
+        jobs = expand_runs(load_scenario(args.scenario))
+    except (OSError, ValueError) as e:
+        parser.error(str(e))
+
+    if args.output == "-":
+        out = sys.stdout
+    else:
+        out = open(args.output, "w", encoding="utf-8", newline="")
+    try:
+        writer = RecordWriter(out, fmt)
+        for record in run_batch(jobs, args.full):
+            writer.write(record)
+    finally:
+        if out is not sys.stdout:
+            out.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,171 @@
+import argparse
+import math
+import time
+from dataclasses import dataclass
+from statistics import NormalDist
+from typing import Dict, Optional, Sequence, Tuple
+
+from smo_food_center import BatchMeans, SMO, TraceLevel
+from smo_replications import t_quantile
+
+
+# Показатели, накапливаемые SMO(batch_means=True)
+BATCH_METRICS = {
+    "wait": "E[Tож]",
+    "system": "E[Tпр]",
+    "buffer": "Lбуф",
+}
+
+# Меньше пакетов дисперсию не оценить; дальше пары не сливаются
+MIN_BATCHES = 10
+
+
+@dataclass
+class BatchMeansEstimate:
+    mean: float
+    half_width: float     # полуширина доверительного интервала
+    batches: int          # пакетов в оценке
+    batch_size: float     # вес пакета: заказов или единиц времени
+    lag1: float           # автокорреляция соседних пакетных средних
+    independent: bool     # прошли ли пакеты проверку на независимость
+
+    @property
+    def relative_half_width(self) -> float:
+        return self.half_width / abs(self.mean) if self.mean else math.inf
+
+
+def lag1_autocorrelation(values: Sequence[float]) -> float:
+    n = len(values)
+    if n < 3:
+        return 0.0
+    m = sum(values) / n
+    d = [v - m for v in values]
+    var = sum(x * x for x in d)
+    if var == 0.0:
+        return 0.0
+    return sum(a * b for a, b in zip(d, d[1:])) / var
+
+
+def analyze(bm: BatchMeans, confidence: float = 0.95, alpha: float = 0.05,
+            min_batches: int = MIN_BATCHES) -> BatchMeansEstimate:
+    # Соседние пакеты сливаются попарно, пока автокорреляция lag-1 их
+    # средних значимо положительна (r1 > z_{1-alpha} / sqrt(k)) и пакетов
+    # остаётся не меньше min_batches. Интервал — t-интервал по k пакетным
+    # средним; точечная оценка — по всем наблюдениям, включая неполный пакет.
+    total, weight = bm.total()
+    mean = total / weight if weight else 0.0
+    sums, weights = list(bm.sums), list(bm.weights)
+    z = NormalDist().inv_cdf(1 - alpha)
+    while True:
+        means = [s / w for s, w in zip(sums, weights)]
+        k = len(means)
+        r1 = lag1_autocorrelation(means)
+        independent = k >= min_batches and r1 <= z / math.sqrt(k)
+        if independent or k // 2 < min_batches:
+            break
+        sums = [sums[i] + sums[i + 1] for i in range(0, k - 1, 2)]
+        weights = [weights[i] + weights[i + 1] for i in range(0, k - 1, 2)]
+    if k < 2:
+        return BatchMeansEstimate(mean, math.inf, k, bm.size, r1, False)
+    m = sum(means) / k
+    s2 = sum((y - m) ** 2 for y in means) / (k - 1)
+    half_width = t_quantile(0.5 + confidence / 2, k - 1) * math.sqrt(s2 / k)
+    return BatchMeansEstimate(mean, half_width, k, sum(weights) / k, r1, independent)
+
+
+def analyze_all(smo, confidence: float = 0.95) -> Dict[str, BatchMeansEstimate]:
+    # smo — SMO или NativeSMO, созданные с batch_means=True
+    return {key: analyze(bm, confidence) for key, bm in smo.batch_means().items()}
+
+
+def precision_reached(estimates: Dict[str, BatchMeansEstimate], precision: float,
+                      keys=("wait",)) -> bool:
+    # Как smo_replications.precision_reached, но ещё и с независимыми пакетами
+    return all(estimates[k].independent and estimates[k].half_width <= precision * abs(estimates[k].mean)
+               for k in keys)
+
+
+def run_to_precision(smo, precision: float, t_max: float, keys=("wait",), first: Optional[float] = None,
+                     confidence: float = 0.95) -> Tuple[Dict[str, BatchMeansEstimate], bool, int]:
+    # Один длинный прогон с проверками в моменты first, 2*first, 4*first, ...
+    # (не дальше t_max): останов, как только интервалы keys достигли
+    # относительной полуширины precision. Возвращает оценки, достигнута ли
+    # точность и число событий.
+    t = first or t_max / 64
+    events = 0
+    while True:
+        t = min(t, t_max)
+        events += smo.run_until(t)
+        estimates = analyze_all(smo, confidence)
+        if precision_reached(estimates, precision, keys):
+            return estimates, True, events
+        if t >= t_max:
+            return estimates, False, events
+        t *= 2
+
+
+def print_batch_estimates(estimates: Dict[str, BatchMeansEstimate], confidence: float = 0.95):
+    print("\n" + "=" * 70)
+    print(f"ПАКЕТНЫЕ СРЕДНИЕ: оценки и {confidence * 100:.0f}% доверительные интервалы")
+    print("=" * 70)
+    for key, label in BATCH_METRICS.items():
+        e = estimates[key]
+        note = "" if e.independent else "  ! пакеты коррелированы, интервал занижен"
+        print(f"  {label:<8} = {e.mean:.4f} ± {e.half_width:.4f}  "
+              f"(k={e.batches}, пакет {e.batch_size:.1f}, r1={e.lag1:+.3f}){note}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Один длинный прогон SMO с оценкой по пакетным средним")
+    parser.add_argument("--t-max", type=float, default=100000.0)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--backend", choices=("python", "native"), default="python")
+    parser.add_argument("--confidence", type=float, default=0.95)
+    parser.add_argument("--restaurants", type=int, default=15)
+    parser.add_argument("--operators", type=int, default=5)
+    parser.add_argument("--interval", type=float, default=10.0)
+    parser.add_argument("--op-mean", type=float, default=2.0)
+    parser.add_argument("--buffer-cap", type=int, default=3)
+    parser.add_argument("--warmup", action="store_true", help="отсечь разгон (MSER-5)")
+    parser.add_argument("--precision", type=float, default=None,
+                        help="остановить прогон (не позже --t-max), когда относительная "
+                             "полуширина интервала E[Tож] станет не больше заданной")
+    args = parser.parse_args()
+    if args.warmup and args.precision is not None:
+        parser.error("--warmup и --precision несовместимы: разгон ищется по всему горизонту")
+
+    params = dict(num_restaurants=args.restaurants, num_operators=args.operators,
+                  interval=args.interval, op_mean=args.op_mean, buffer_cap=args.buffer_cap,
+                  seed=args.seed, batch_means=True)
+    if args.backend == "native":
+        from smo_native import NativeSMO
+
+        def make_model():
+            return NativeSMO(**params)
+    else:
+        def make_model():
+            return SMO(**params, trace=TraceLevel.OFF)
+
+    start = time.perf_counter()
+    if args.warmup:
+        from smo_warmup import run_with_warmup
+        smo, t_w, _ = run_with_warmup(make_model, args.t_max)
+        print(f"Разгон (MSER-5): t_w = {t_w:.2f}")
+        estimates = analyze_all(smo, args.confidence)
+    elif args.precision is not None:
+        smo = make_model()
+        estimates, converged, events = run_to_precision(smo, args.precision, args.t_max,
+                                                        confidence=args.confidence)
+        state = "достигнута" if converged else "НЕ достигнута до --t-max"
+        print(f"Точность {args.precision:.3f}: {state}; модельное время {smo.time:.0f}, событий {events}")
+    else:
+        smo = make_model()
+        smo.run_until(args.t_max)
+        estimates = analyze_all(smo, args.confidence)
+    elapsed = time.perf_counter() - start
+    print_batch_estimates(estimates, args.confidence)
+    print(f"\nСчёт: {elapsed:.2f} с")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,516 @@
+import argparse
+import array
+import gc
+import math
+import os
+import struct
+import sys
+import time
+from typing import List, Optional
+
+from smo_food_center import (
+    EVENT_SETS, MASK64, PRIO_ARRIVAL, PRIO_COMPLETION, REGENERATIVE_METRICS, SMO, Event, EventType,
+    Order, SampledRunningStats, TraceLevel,
+)
+
+
+# Снимок состояния SMO/NativeSMO (native/smo_checkpoint.cpp пишет тот же
+# формат, поэтому снимок одного движка продолжается другим). Всё
+# little-endian, без выравнивания:
+#   заголовок HEADER;
+#   рестораны, по столбцу на поле (N): generated q, generated_base q,
+#     next_time d, rejected Q, выдано потоком заказов (crn) Q, затем
+#     T ожидания и T пребывания — count Q, mean d, m2 d, min d, max d;
+#   операторы (M): busy B, batch_restaurant_id i (-1 — нет), busy_time d,
+#     last_start_time d, wait_time d текущего заказа, выдано потоком Q,
+#     текущий заказ — restaurant_id i, order_id q, timestamp d, service_time d
+#     (-1 — не задано);
+#   буфер (L) в порядке поступления: те же четыре поля заказа;
+#   события (E) по возрастанию ключа: time d, (priority << 62) | seq Q,
+#     ресторан или оператор i;
+#   при FLAG_BATCH_MEANS — три BatchMeans (BATCH + sums d + weights d) и
+#     buffer_area/время последнего завершения d d;
+#   при FLAG_REGENERATIVE — started I, пять RATIO, REGEN_TAIL.
+# Потоки хранятся числом выданных значений: ключи выводятся из seed, а
+# генератор догоняет позицию лениво при продолжении (RandomStream.seek).
+# Версия 2: поток — один генератор на ключ (в версии 1 генератор засевался
+# заново на каждый блок), поэтому снимки версии 1 не читаются.
+# У свободного оператора поля заказа, last_start_time и wait_time нулевые,
+# так что оба движка пишут побайтно одинаковые снимки.
+# Журнал событий (last_events) в снимок не входит.
+MAGIC = b"SMOSNAP\0"
+VERSION = 2
+FLAG_CRN = 1
+FLAG_ANTITHETIC = 2
+FLAG_BATCH_MEANS = 4
+FLAG_REGENERATIVE = 8
+
+HEADER = struct.Struct("<8sIIiiiiddQddddQQQQQQQ")
+HEADER_FIELDS = ("magic", "version", "flags", "num_restaurants", "num_operators", "buffer_cap",
+                 "buffer_length", "interval", "op_mean", "seed", "time", "last_event_time",
+                 "buffer_area", "stats_start", "total_generated", "total_processed", "total_rejected",
+                 "next_seq", "n_to_operator", "n_to_buffer", "num_events")
+BATCH = struct.Struct("<iiddd")
+BUFFER_MARK = struct.Struct("<dd")
+RATIO = struct.Struct("<Qddddd")
+REGEN_HEAD = struct.Struct("<I")
+REGEN_TAIL = struct.Struct("<ddQQQdd")
+PRIO_SHIFT = 62
+SEQ_MASK = (1 << PRIO_SHIFT) - 1
+
+# Типы столбцов ресторанов и операторов по порядку; IDLE_OPERATOR — значения
+# столбцов нового свободного оператора (with_changes); *_DRAWN — номера
+# столбцов "выдано потоком" (with_seed)
+RESTAURANT_COLUMNS = "qqdQQ" + "Qdddd" * 2
+OPERATOR_COLUMNS = "BidddQiqdd"
+RESTAURANT_DRAWN = 4
+OPERATOR_DRAWN = 5
+IDLE_OPERATOR = (0, -1, 0.0, 0.0, 0.0, 0, -1, -1, 0.0, -1.0)
+
+_SWAP = sys.byteorder == "big"
+KNOWN_FLAGS = FLAG_CRN | FLAG_ANTITHETIC | FLAG_BATCH_MEANS | FLAG_REGENERATIVE
+assert [array.array(t).itemsize for t in "BiqQd"] == [1, 4, 8, 8, 8]
+
+
+def bad_checkpoint(what: str) -> ValueError:
+    # единая ошибка повреждённого снимка для обоих движков (NativeSMO —
+    # с тем же текстом из smo_checkpoint.cpp)
+    return ValueError(f"bad checkpoint: {what}")
+
+
+def _width(typecodes: str) -> int:
+    return sum(array.array(t).itemsize for t in typecodes)
+
+
+def _column(typecode: str, values) -> bytes:
+    a = array.array(typecode, values)
+    if _SWAP:
+        a.byteswap()
+    return a.tobytes()
+
+
+class _Reader:
+    def __init__(self, data: bytes):
+        self.data = memoryview(data)
+        self.pos = 0
+
+    def unpack(self, s: struct.Struct) -> tuple:
+        if len(self.data) - self.pos < s.size:
+            raise bad_checkpoint("обрезан")
+        values = s.unpack_from(self.data, self.pos)
+        self.pos += s.size
+        return values
+
+    def column(self, typecode: str, n: int) -> array.array:
+        a = array.array(typecode)
+        end = self.pos + a.itemsize * n
+        if end > len(self.data):
+            raise bad_checkpoint("обрезан")
+        a.frombytes(self.data[self.pos:end])
+        if _SWAP:
+            a.byteswap()
+        self.pos = end
+        return a
+
+
+def read_header(data: bytes) -> dict:
+    # Заголовок с проверкой версии, флагов и размеров: столбцы ресторанов и
+    # операторов должны поместиться в data, иначе битый заголовок заставил
+    # бы построить модель на миллиарды операторов
+    if len(data) < HEADER.size:
+        raise bad_checkpoint("обрезан")
+    header = dict(zip(HEADER_FIELDS, HEADER.unpack_from(data)))
+    if header["magic"] != MAGIC:
+        raise bad_checkpoint("не снимок SMO")
+    if header["version"] != VERSION:
+        raise bad_checkpoint(f"неподдерживаемая версия {header['version']}")
+    flags = header["flags"]
+    if flags & ~KNOWN_FLAGS:
+        raise bad_checkpoint("неизвестные флаги")
+    n, m, length = header["num_restaurants"], header["num_operators"], header["buffer_length"]
+    if n < 0 or m < 0 or not 0 <= length <= header["buffer_cap"] or not n <= header["num_events"] <= n + m:
+        raise bad_checkpoint("неверные размеры модели")
+    if not (0 < header["interval"] < math.inf and 0 < header["op_mean"] < math.inf):
+        raise bad_checkpoint("неверные параметры модели")
+    if not (0 <= header["stats_start"] <= header["last_event_time"] <= header["time"] < math.inf):
+        raise bad_checkpoint("неверное модельное время")
+    if header["next_seq"] > SEQ_MASK:
+        raise bad_checkpoint("неверный счётчик событий")
+    body = (_width(RESTAURANT_COLUMNS) * n + _width(OPERATOR_COLUMNS) * m + _width("iqdd") * length
+            + _width("dQi") * header["num_events"])
+    if len(data) - HEADER.size < body:
+        raise bad_checkpoint("обрезан")
+    header.update(crn=bool(flags & FLAG_CRN), antithetic=bool(flags & FLAG_ANTITHETIC),
+                  batch_means=bool(flags & FLAG_BATCH_MEANS), regenerative=bool(flags & FLAG_REGENERATIVE))
+    return header
+
+
+def _stats_columns(stats) -> List[bytes]:
+    return [_column("Q", [s.count for s in stats]),
+            _column("d", [s.mean for s in stats]),
+            _column("d", [s.m2 for s in stats]),
+            _column("d", [s.min for s in stats]),
+            _column("d", [s.max for s in stats])]
+
+
+def _order_columns(orders: List[Optional[Order]]) -> List[bytes]:
+    none = Order(-1, -1, 0.0)
+    orders = [o or none for o in orders]
+    return [_column("i", [o.restaurant_id for o in orders]),
+            _column("q", [o.order_id for o in orders]),
+            _column("d", [o.timestamp for o in orders]),
+            _column("d", [-1.0 if o.service_time is None else o.service_time for o in orders])]
+
+
+def dumps(smo) -> bytes:
+    # Снимок модели между шагами; NativeSMO пишет его в C++
+    if not isinstance(smo, SMO):
+        return smo.checkpoint()
+    if smo._stats_type is SampledRunningStats:
+        raise ValueError("keep_samples: сырые наблюдения в снимок не входят")
+    if smo.arrivals is not None:
+        raise ValueError("arrivals: позиция в журнале поступлений в снимок не входит")
+
+    entries = sorted(smo.event_queue.entries())
+    wait_time = [0.0] * len(smo.operators)
+    entities = []
+    for _, _, _, ev in entries:
+        if ev.etype is EventType.ORDER_GENERATED:
+            entities.append(ev.restaurant_id)
+        else:
+            entities.append(ev.operator_id)
+            wait_time[ev.operator_id] = ev.wait_time
+
+    flags = ((FLAG_CRN if smo.crn else 0) | (FLAG_ANTITHETIC if smo.antithetic else 0)
+             | (FLAG_BATCH_MEANS if smo.batch_collector else 0)
+             | (FLAG_REGENERATIVE if smo.regen_collector else 0))
+    parts = [HEADER.pack(
+        MAGIC, VERSION, flags, len(smo.restaurants), len(smo.operators), smo.buffer.capacity,
+        len(smo.buffer), smo.interval, smo.op_mean, smo.seed,
+        smo.time, smo.last_event_time, smo.buffer_area, smo.stats_start,
+        smo.total_generated, smo.total_processed, smo.total_rejected, smo._next_seq,
+        smo._n_to_operator, smo._n_to_buffer, len(entries))]
+
+    sources = smo.restaurants
+    parts.append(_column("q", [s.generated for s in sources]))
+    parts.append(_column("q", smo._generated_base))
+    parts.append(_column("d", [s.next_time for s in sources]))
+    parts.append(_column("Q", smo.rejected_by_restaurant))
+    parts.append(_column("Q", [s.tell() for s in smo._order_streams] if smo.crn else [0] * len(sources)))
+    parts += _stats_columns(smo.wait_stats)
+    parts += _stats_columns(smo.system_stats)
+
+    ops = smo.operators
+    parts.append(_column("B", [op.busy for op in ops]))
+    parts.append(_column("i", [-1 if op.batch_restaurant_id is None else op.batch_restaurant_id for op in ops]))
+    parts.append(_column("d", [op.busy_time for op in ops]))
+    parts.append(_column("d", [op.last_start_time if op.busy else 0.0 for op in ops]))
+    parts.append(_column("d", wait_time))
+    parts.append(_column("Q", [op.stream.tell() for op in ops]))
+    parts += _order_columns([op.current_order for op in ops])
+
+    parts += _order_columns(smo.buffer.orders)
+
+    parts.append(_column("d", [e[0] for e in entries]))
+    parts.append(_column("Q", [e[1] << PRIO_SHIFT | e[2] for e in entries]))
+    parts.append(_column("i", entities))
+
+    if smo.batch_collector:
+        c = smo.batch_collector
+        for bm in (c.wait, c.system, c.buffer):
+            parts.append(BATCH.pack(bm.max_batches, len(bm.sums), bm.size, bm._sum, bm._weight))
+            parts.append(_column("d", bm.sums))
+            parts.append(_column("d", bm.weights))
+        parts.append(BUFFER_MARK.pack(c._area, c._time))
+    if smo.regen_collector:
+        g = smo.regen_collector
+        parts.append(REGEN_HEAD.pack(g.started))
+        for key in REGENERATIVE_METRICS:
+            rs = g.stats[key]
+            parts.append(RATIO.pack(rs.count, rs.mean_y, rs.mean_x, rs.cyy, rs.cxx, rs.cxy))
+        parts.append(REGEN_TAIL.pack(g.wait, g.system, g._generated, g._rejected, g._processed,
+                                     g._area, g._time))
+    return b"".join(parts)
+
+
+def _read_stats(r: _Reader, stats, n: int):
+    # в существующие накопители: их приёмники (пакетные средние, циклы) сохраняются
+    for field, typecode in (("count", "Q"), ("mean", "d"), ("m2", "d"), ("min", "d"), ("max", "d")):
+        for st, v in zip(stats, r.column(typecode, n)):
+            setattr(st, field, v)
+
+
+def _read_orders(r: _Reader, n: int) -> List[Order]:
+    rid, oid, ts, st = r.column("i", n), r.column("q", n), r.column("d", n), r.column("d", n)
+    return [Order(rid[i], oid[i], ts[i], None if st[i] < 0.0 else st[i]) for i in range(n)]
+
+
+def loads(data: bytes, backend: str = "python", **options):
+    # Модель из снимка. options — настройки Python-движка, не входящие в
+    # состояние: event_set, trace, log_capacity.
+    if backend == "native":
+        from smo_native import NativeSMO
+        return NativeSMO.from_checkpoint(data)
+    if options.get("keep_samples"):
+        raise ValueError("keep_samples: сырые наблюдения в снимок не входят")
+    # сотни тысяч новых объектов без пауз циклического сборщика: на модели
+    # из 100k операторов это в разы быстрее
+    enabled = gc.isenabled()
+    gc.disable()
+    try:
+        return _restore(data, options)
+    finally:
+        if enabled:
+            gc.enable()
+
+
+def _restore(data: bytes, options: dict) -> SMO:
+    h = read_header(data)
+    n, m = h["num_restaurants"], h["num_operators"]
+    r = _Reader(data)
+    r.pos = HEADER.size
+
+    smo = SMO(num_restaurants=n, num_operators=m, interval=h["interval"], op_mean=h["op_mean"],
+              buffer_cap=h["buffer_cap"], seed=h["seed"], crn=h["crn"], antithetic=h["antithetic"],
+              batch_means=h["batch_means"], regenerative=h["regenerative"], **options)
+    smo.event_queue = EVENT_SETS[options.get("event_set", "heap")](n, m)
+    smo._next_seq = h["next_seq"]
+    smo.time = h["time"]
+    smo.last_event_time = h["last_event_time"]
+    smo.buffer_area = h["buffer_area"]
+    smo.stats_start = h["stats_start"]
+    smo.total_generated = h["total_generated"]
+    smo.total_processed = h["total_processed"]
+    smo.total_rejected = h["total_rejected"]
+    smo._n_to_operator = h["n_to_operator"]
+    smo._n_to_buffer = h["n_to_buffer"]
+
+    generated = r.column("q", n)
+    smo._generated_base = list(r.column("q", n))
+    next_times = r.column("d", n)
+    # ожидающее поступление ресторана уже учтено в generated, так что
+    # generated >= 1 (иначе у этого поступления был бы заказ с номером -1)
+    if (any(k < 1 or not 0 <= base <= k for base, k in zip(smo._generated_base, generated))
+            or any(not smo.time <= t < math.inf for t in next_times)):
+        raise bad_checkpoint("неверные счётчики ресторанов")
+    for src, k, next_time in zip(smo.restaurants, generated, next_times):
+        src.generated = k
+        src.next_time = next_time
+    smo.rejected_by_restaurant = list(r.column("Q", n))
+    drawn = r.column("Q", n)
+    # каждое значение потока берётся вместе с планированием события (заказ
+    # с crn — при поступлении, оператор — при начале обслуживания), так что
+    # всего выдано не больше next_seq; иначе seek догонял бы позицию часами
+    drawn_total = sum(drawn)
+    if smo.crn:
+        for stream, k in zip(smo._order_streams, drawn):
+            stream.seek(k)
+    _read_stats(r, smo.wait_stats, n)
+    _read_stats(r, smo.system_stats, n)
+
+    busy = r.column("B", m)
+    batch = r.column("i", m)
+    busy_time = r.column("d", m)
+    last_start = r.column("d", m)
+    wait_time = r.column("d", m)
+    drawn = r.column("Q", m)
+    current = _read_orders(r, m)
+    if drawn_total + sum(drawn) > smo._next_seq:
+        raise bad_checkpoint("неверные позиции потоков")
+    if any(b > 1 for b in busy) or any(not -1 <= k < n for k in batch):
+        raise bad_checkpoint("неверное состояние оператора")
+    if any(busy[i] and not 0 <= current[i].restaurant_id < n for i in range(m)):
+        raise bad_checkpoint("неверный заказ оператора")
+    for i, op in enumerate(smo.operators):
+        op.stream.seek(drawn[i])
+        op.batch_restaurant_id = None if batch[i] < 0 else batch[i]
+        op.busy_time = busy_time[i]
+        if busy[i]:
+            op.busy = True
+            op.current_order = current[i]
+            op.last_start_time = last_start[i]
+            smo.free_operators.acquire(i)
+
+    for order in _read_orders(r, h["buffer_length"]):
+        if not 0 <= order.restaurant_id < n:
+            raise bad_checkpoint("неверный заказ в буфере")
+        smo.buffer.add_fifo(order)
+
+    # у каждого ресторана ровно одно ожидающее поступление, у каждого
+    # занятого оператора — одно завершение
+    e = h["num_events"]
+    times, keys, entities = r.column("d", e), r.column("Q", e), r.column("i", e)
+    pending = [0] * n
+    finishing = [0] * m
+    for t, key, entity in zip(times, keys, entities):
+        prio, seq = key >> PRIO_SHIFT, key & SEQ_MASK
+        if seq >= smo._next_seq or not smo.time <= t < math.inf:
+            raise bad_checkpoint("неверное событие")
+        if prio == PRIO_ARRIVAL and 0 <= entity < n:
+            pending[entity] += 1
+            ev = Event(t, EventType.ORDER_GENERATED, restaurant_id=entity,
+                       order_id=smo.restaurants[entity].generated - 1)
+        elif prio == PRIO_COMPLETION and 0 <= entity < m and busy[entity]:
+            finishing[entity] += 1
+            order = smo.operators[entity].current_order
+            ev = Event(t, EventType.OPERATOR_FREE, restaurant_id=order.restaurant_id,
+                       order_id=order.order_id, operator_id=entity, wait_time=wait_time[entity])
+        else:
+            raise bad_checkpoint("неверное событие")
+        smo.event_queue.push((t, prio, seq, ev))
+    if any(k != 1 for k in pending) or any(k != b for k, b in zip(finishing, busy)):
+        raise bad_checkpoint("неверный календарь событий")
+
+    if h["batch_means"]:
+        c = smo.batch_collector
+        for bm in (c.wait, c.system, c.buffer):
+            bm.max_batches, k, bm.size, bm._sum, bm._weight = r.unpack(BATCH)
+            if not 0 <= k < bm.max_batches or bm.max_batches < 2 or bm.max_batches % 2:
+                raise bad_checkpoint("неверные пакетные средние")
+            bm.sums = list(r.column("d", k))
+            bm.weights = list(r.column("d", k))
+        c._area, c._time = r.unpack(BUFFER_MARK)
+    if h["regenerative"]:
+        g = smo.regen_collector
+        g.started = bool(r.unpack(REGEN_HEAD)[0])
+        for key in REGENERATIVE_METRICS:
+            rs = g.stats[key]
+            rs.count, rs.mean_y, rs.mean_x, rs.cyy, rs.cxx, rs.cxy = r.unpack(RATIO)
+        (g.wait, g.system, g._generated, g._rejected, g._processed,
+         g._area, g._time) = r.unpack(REGEN_TAIL)
+    if r.pos != len(data):
+        raise bad_checkpoint("лишние данные в конце")
+    return smo
+
+
+def with_changes(data: bytes, num_operators: Optional[int] = None, buffer_cap: Optional[int] = None,
+                 op_mean: Optional[float] = None, interval: Optional[float] = None) -> bytes:
+    # Снимок с изменёнными параметрами — для ветвления "что если" (smo_fork).
+    # Новые операторы добавляются свободными, их потоки выводятся из seed по
+    # номеру, как у модели, сразу созданной с таким числом операторов.
+    # interval действует со следующего поступления каждого ресторана,
+    # op_mean — со следующего начала обслуживания. С crn заказ получает время
+    # обслуживания при поступлении, поэтому у заказов в буфере оно
+    # пересчитывается в масштабе нового op_mean; у обслуживаемых сейчас
+    # завершение уже запланировано и не меняется.
+    h = read_header(data)
+    n, m = h["num_restaurants"], h["num_operators"]
+    scale = 1.0 if op_mean is None else op_mean / h["op_mean"]
+    num_operators = m if num_operators is None else num_operators
+    buffer_cap = h["buffer_cap"] if buffer_cap is None else buffer_cap
+    op_mean = h["op_mean"] if op_mean is None else op_mean
+    interval = h["interval"] if interval is None else interval
+    if num_operators < m:
+        raise ValueError(f"операторов можно только добавить: в модели уже {m}")
+    if buffer_cap < h["buffer_length"]:
+        raise ValueError(f"в буфере {h['buffer_length']} заказов, ёмкость {buffer_cap} меньше")
+    if op_mean <= 0 or interval <= 0:
+        raise ValueError("op_mean и interval должны быть положительными")
+
+    h.update(num_operators=num_operators, buffer_cap=buffer_cap, op_mean=op_mean, interval=interval)
+    parts = [HEADER.pack(*(h[k] for k in HEADER_FIELDS))]
+    r = _Reader(data)
+    r.pos = HEADER.size
+    for typecode in RESTAURANT_COLUMNS:
+        r.column(typecode, n)
+    parts.append(bytes(r.data[HEADER.size:r.pos]))
+    for typecode, idle in zip(OPERATOR_COLUMNS, IDLE_OPERATOR):
+        start = r.pos
+        r.column(typecode, m)
+        parts.append(bytes(r.data[start:r.pos]))
+        parts.append(_column(typecode, [idle] * (num_operators - m)))
+    start = r.pos
+    for typecode in "iqd":
+        r.column(typecode, h["buffer_length"])
+    parts.append(bytes(r.data[start:r.pos]))
+    service_times = r.column("d", h["buffer_length"])
+    if h["crn"] and scale != 1.0:
+        service_times = [t * scale if t >= 0.0 else t for t in service_times]
+    parts.append(_column("d", service_times))
+    parts.append(bytes(r.data[r.pos:]))
+    return b"".join(parts)
+
+
+def with_seed(data: bytes, seed: int, antithetic: Optional[bool] = None) -> bytes:
+    # Снимок с новым корневым ключом: при загрузке все потоки выводятся из
+    # seed заново и читаются с начала, состояние очереди остаётся прежним.
+    # Так из одного прогретого состояния получаются независимые продолжения
+    # (smo_replications, shared_warmup); antithetic меняет вид потоков.
+    h = read_header(data)
+    n, m = h["num_restaurants"], h["num_operators"]
+    h["seed"] = seed & MASK64
+    if antithetic is not None:
+        h["flags"] = h["flags"] & ~FLAG_ANTITHETIC | (FLAG_ANTITHETIC if antithetic else 0)
+    out = bytearray(data)
+    HEADER.pack_into(out, 0, *(h[k] for k in HEADER_FIELDS))
+
+    restaurants = HEADER.size + _width(RESTAURANT_COLUMNS) * n
+    start = HEADER.size + _width(RESTAURANT_COLUMNS[:RESTAURANT_DRAWN]) * n
+    out[start:start + 8 * n] = bytes(8 * n)
+    start = restaurants + _width(OPERATOR_COLUMNS[:OPERATOR_DRAWN]) * m
+    out[start:start + 8 * m] = bytes(8 * m)
+    return bytes(out)
+
+
+def save(smo, path: str):
+    # запись через временный файл: при аварии остаётся прежний снимок
+    data = dumps(smo)
+    tmp = path + ".tmp"
+    with open(tmp, "wb") as f:
+        f.write(data)
+        f.flush()
+        os.fsync(f.fileno())
+    os.replace(tmp, path)
+
+
+def load(path: str, backend: str = "python", **options):
+    with open(path, "rb") as f:
+        return loads(f.read(), backend, **options)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Длинный прогон SMO со снимками состояния и продолжением")
+    parser.add_argument("snapshot", help="файл снимка; если он есть, прогон продолжается с него")
+    parser.add_argument("--t-max", type=float, default=1e6)
+    parser.add_argument("--every", type=int, default=2_000_000, help="событий между снимками")
+    parser.add_argument("--backend", choices=("python", "native"), default="python")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--restaurants", type=int, default=15)
+    parser.add_argument("--operators", type=int, default=5)
+    parser.add_argument("--interval", type=float, default=10.0)
+    parser.add_argument("--op-mean", type=float, default=2.0)
+    parser.add_argument("--buffer-cap", type=int, default=3)
+    args = parser.parse_args()
+
+    options = {} if args.backend == "native" else {"trace": TraceLevel.OFF}
+    if os.path.exists(args.snapshot):
+        try:
+            smo = load(args.snapshot, args.backend, **options)
+        except (OSError, ValueError) as e:
+            parser.error(f"{args.snapshot}: {e}")
+        print(f"Продолжение с t = {smo.time:.2f} (параметры модели — из снимка)", file=sys.stderr)
+    else:
+        params = dict(num_restaurants=args.restaurants, num_operators=args.operators,
+                      interval=args.interval, op_mean=args.op_mean, buffer_cap=args.buffer_cap,
+                      seed=args.seed)
+        if args.backend == "native":
+            from smo_native import NativeSMO
+            smo = NativeSMO(**params)
+        else:
+            smo = SMO(**params, **options)
+
+    while smo.time < args.t_max:
+        events = smo.run_until(args.t_max, args.every)
+        start = time.perf_counter()
+        save(smo, args.snapshot)
+        elapsed = time.perf_counter() - start
+        print(f"t = {smo.time:.2f}: снимок {os.path.getsize(args.snapshot)} байт за {elapsed * 1000:.1f} мс",
+              file=sys.stderr)
+        if events < args.every:
+            break   # горизонт достигнут или календарь пуст
+    smo.print_statistics()
+    smo.print_extended_statistics()
+
+
+if __name__ == "__main__":
+    main()
@@ -1,8 +1,11 @@
 import heapq
+import math
 import random
+from bisect import insort
+from collections import deque
 from dataclasses import dataclass
 from enum import Enum, auto
-from typing import Optional, List
+from typing import Optional, List, Tuple
 
 
 class EventType(Enum):
@@ -13,15 +16,36 @@ class EventType(Enum):
     ORDER_REJECTED = auto()
 
 
-@dataclass(order=True)
+class TraceLevel(Enum):
+    OFF = 0        # ничего не журналируется, step() без вызовов трассировки
+    COUNTERS = 1   # только счётчики событий по типам, без объектов Event
+    REJECTS = 2    # в журнал попадают только отказы
+    FULL = 3       # все события (журнал календаря ОД3)
+
+
 class Event:
-    time: float
-    etype: EventType
-    restaurant_id: int = -1
-    order_id: int = -1
-    operator_id: int = -1
-    buffer_pos: int = -1
-    wait_time: float = 0.0
+    # Компактная запись события без сравнения по полям: в календарь событий
+    # попадает кортеж-ключ (time, priority, seq, event), см. SMO.push_event.
+    __slots__ = ("time", "etype", "restaurant_id", "order_id",
+                 "operator_id", "buffer_pos", "wait_time")
+
+    def __init__(
+        self,
+        time: float,
+        etype: EventType,
+        restaurant_id: int = -1,
+        order_id: int = -1,
+        operator_id: int = -1,
+        buffer_pos: int = -1,
+        wait_time: float = 0.0
+    ):
+        self.time = time
+        self.etype = etype
+        self.restaurant_id = restaurant_id
+        self.order_id = order_id
+        self.operator_id = operator_id
+        self.buffer_pos = buffer_pos
+        self.wait_time = wait_time
 
     def __str__(self) -> str:
         return (
@@ -32,51 +56,589 @@ class Event:
         )
 
 
+# Правило разрешения одновременных событий: при равном time сначала
+# завершения обслуживания (освободившийся оператор может сразу взять
+# заявку), затем поступления; внутри класса — FIFO по порядку планирования.
+PRIO_COMPLETION = 0
+PRIO_ARRIVAL = 1
+
+# Элемент календаря: (time, priority, seq, event). seq уникален, поэтому
+# кортежи сравниваются не дальше третьего поля и до Event дело не доходит.
+EventKey = Tuple[float, int, int, Event]
+
+
+class HeapEventQueue:
+    # Календарь событий на бинарной куче: O(log n) на push/pop.
+    def __init__(self):
+        self._heap: List[EventKey] = []
+
+    def push(self, entry: EventKey):
+        heapq.heappush(self._heap, entry)
+
+    def pop(self) -> Event:
+        return heapq.heappop(self._heap)[3]
+
+    def entries(self) -> List[EventKey]:
+        # ожидающие события в произвольном порядке (снимок состояния)
+        return list(self._heap)
+
+    def __len__(self) -> int:
+        return len(self._heap)
+
+
+class CalendarQueue:
+    # Календарная очередь (R. Brown, 1988): кольцо "дней" ширины width,
+    # каждое событие попадает в день int(time / width) % nbuckets.
+    # При удвоении/уменьшении числа событий кольцо перестраивается,
+    # а ширина дня подбирается по среднему интервалу между ближайшими событиями.
+    # Амортизированно O(1) на push/pop.
+
+    MIN_BUCKETS = 2
+    WIDTH_SAMPLE = 25
+
+    def __init__(self, nbuckets: int = 2, width: float = 1.0):
+        self._size = 0
+        self._last_time = 0.0
+        self._setup(max(nbuckets, self.MIN_BUCKETS), width)
+
+    def _setup(self, nbuckets: int, width: float):
+        self._nbuckets = nbuckets
+        self._width = width
+        self._buckets: List[List[EventKey]] = [[] for _ in range(nbuckets)]
+        # номер текущего "дня" (без взятия по модулю); все ожидающие события
+        # не раньше последнего извлечённого, поэтому и не раньше этого дня
+        self._day = int(self._last_time / width)
+        self._grow_at = 2 * nbuckets
+        self._shrink_at = nbuckets // 2 if nbuckets > self.MIN_BUCKETS else -1
+
+    def push(self, entry: EventKey):
+        bucket = self._buckets[int(entry[0] / self._width) % self._nbuckets]
+        if not bucket or bucket[-1] < entry:
+            bucket.append(entry)
+        else:
+            insort(bucket, entry)
+        self._size += 1
+        if self._size > self._grow_at:
+            self._resize(self._nbuckets * 2)
+
+    def pop(self) -> Event:
+        if self._size == 0:
+            raise IndexError("pop from empty calendar queue")
+
+        buckets = self._buckets
+        nb = self._nbuckets
+        width = self._width
+        day = self._day
+        for _ in range(nb):
+            bucket = buckets[day % nb]
+            if bucket and int(bucket[0][0] / width) == day:
+                return self._take(bucket, day)
+            day += 1
+
+        # за целый "год" ничего не нашли — прямой поиск минимума по головам
+        best = None
+        for bucket in buckets:
+            if bucket and (best is None or bucket[0] < best[0]):
+                best = bucket
+        return self._take(best, int(best[0][0] / width))
+
+    def _take(self, bucket: List[EventKey], day: int) -> Event:
+        entry = bucket.pop(0)
+        self._day = day
+        self._last_time = entry[0]
+        self._size -= 1
+        if self._size < self._shrink_at:
+            self._resize(self._nbuckets // 2)
+        return entry[3]
+
+    def _resize(self, nbuckets: int):
+        entries = [e for bucket in self._buckets for e in bucket]
+        width = self._new_width(entries)
+        self._setup(nbuckets, width)
+        for e in sorted(entries):
+            self._buckets[int(e[0] / width) % nbuckets].append(e)
+
+    def _new_width(self, entries: List[EventKey]) -> float:
+        sample = heapq.nsmallest(self.WIDTH_SAMPLE, entries)
+        if len(sample) < 2:
+            return self._width
+        gaps = [b[0] - a[0] for a, b in zip(sample, sample[1:])]
+        avg = sum(gaps) / len(gaps)
+        # отбрасываем выбросы, как в оригинальной схеме Брауна
+        small = [g for g in gaps if g <= 2.0 * avg]
+        avg = sum(small) / len(small) if small else avg
+        return 3.0 * avg if avg > 0 else self._width
+
+    def entries(self) -> List[EventKey]:
+        return [e for bucket in self._buckets for e in bucket]
+
+    def __len__(self) -> int:
+        return self._size
+
+
+class IndexedEventSet:
+    # Индексированная min-куча по сущностям: у каждого ресторана не больше
+    # одного ожидающего ORDER_GENERATED, у каждого оператора — не больше
+    # одного OPERATOR_FREE. Слоты 0..N-1 — рестораны, N..N+M-1 — операторы.
+    # Массивы фиксированы (N+M), повторный push в занятый слот обновляет
+    # событие на месте (decrease/increase-key), новых элементов не создаётся.
+
+    def __init__(self, num_restaurants: int, num_operators: int):
+        size = num_restaurants + num_operators
+        self._num_restaurants = num_restaurants
+        self._keys: List[Optional[EventKey]] = [None] * size
+        self._heap: List[int] = [0] * size     # слоты в порядке кучи
+        self._pos: List[int] = [-1] * size     # позиция слота в куче, -1 — не в куче
+        self._size = 0
+        self._stale = -1                       # слот извлечённого, но ещё не удалённого корня
+
+    def _slot(self, ev: Event) -> int:
+        if ev.etype is EventType.ORDER_GENERATED:
+            return ev.restaurant_id
+        return self._num_restaurants + ev.operator_id
+
+    def push(self, entry: EventKey):
+        slot = self._slot(entry[3])
+        if slot == self._stale:
+            # типичный случай в step(): источник сразу планирует следующее
+            # событие в слот только что извлечённого — одна просейка вниз
+            self._stale = -1
+            self._keys[slot] = entry
+            self._sift_down(0)
+            return
+        if self._stale >= 0:
+            self._remove_root()
+
+        pos = self._pos[slot]
+        old = self._keys[slot]
+        self._keys[slot] = entry
+        if pos < 0:
+            pos = self._size
+            self._size += 1
+            self._heap[pos] = slot
+            self._pos[slot] = pos
+            self._sift_up(pos)
+        elif entry < old:
+            self._sift_up(pos)
+        else:
+            self._sift_down(pos)
+
+    def pop(self) -> Event:
+        if self._stale >= 0:
+            self._remove_root()
+        if self._size == 0:
+            raise IndexError("pop from empty indexed event set")
+        # корень не удаляется сразу: если следующий push придёт в тот же
+        # слот, событие будет заменено на месте
+        top = self._heap[0]
+        self._stale = top
+        return self._keys[top][3]
+
+    def _remove_root(self):
+        top = self._stale
+        self._stale = -1
+        self._size -= 1
+        if self._size > 0:
+            last = self._heap[self._size]
+            self._heap[0] = last
+            self._pos[last] = 0
+            self._sift_down(0)
+        self._pos[top] = -1
+        self._keys[top] = None
+
+    def _sift_up(self, pos: int):
+        heap, keys, where = self._heap, self._keys, self._pos
+        slot = heap[pos]
+        key = keys[slot]
+        while pos > 0:
+            parent = (pos - 1) >> 1
+            pslot = heap[parent]
+            if not (key < keys[pslot]):
+                break
+            heap[pos] = pslot
+            where[pslot] = pos
+            pos = parent
+        heap[pos] = slot
+        where[slot] = pos
+
+    def _sift_down(self, pos: int):
+        heap, keys, where = self._heap, self._keys, self._pos
+        size = self._size
+        slot = heap[pos]
+        key = keys[slot]
+        while True:
+            child = 2 * pos + 1
+            if child >= size:
+                break
+            right = child + 1
+            if right < size and keys[heap[right]] < keys[heap[child]]:
+                child = right
+            cslot = heap[child]
+            if not (keys[cslot] < key):
+                break
+            heap[pos] = cslot
+            where[cslot] = pos
+            pos = child
+        heap[pos] = slot
+        where[slot] = pos
+
+    def entries(self) -> List[EventKey]:
+        # извлечённый, но ещё не удалённый корень уже не ожидает
+        return [self._keys[slot] for slot in self._heap[:self._size] if slot != self._stale]
+
+    def __len__(self) -> int:
+        return self._size - (self._stale >= 0)
+
+
+EVENT_SETS = {
+    "heap": lambda num_restaurants, num_operators: HeapEventQueue(),
+    "calendar": lambda num_restaurants, num_operators: CalendarQueue(),
+    "indexed": IndexedEventSet,
+}
+
+
+class EventLog:
+    # Журнал последних событий: кольцевой буфер фиксированной ёмкости,
+    # слоты выделяются один раз, добавление O(1), старые записи вытесняются.
+    # Поддерживает len, итерацию и срезы в хронологическом порядке,
+    # поэтому читается так же, как обычный список.
+
+    def __init__(self, capacity: int):
+        if capacity < 1:
+            raise ValueError("ёмкость журнала событий должна быть >= 1")
+        self.capacity = capacity
+        self._slots: List[Optional[Event]] = [None] * capacity
+        self._next = 0
+        self._total = 0
+
+    def append(self, ev: Event):
+        self._slots[self._next] = ev
+        self._next += 1
+        if self._next == self.capacity:
+            self._next = 0
+        self._total += 1
+
+    def __len__(self) -> int:
+        return min(self._total, self.capacity)
+
+    def __iter__(self):
+        if self._total < self.capacity:
+            return iter(self._slots[:self._total])
+        return iter(self._slots[self._next:] + self._slots[:self._next])
+
+    def __getitem__(self, key):
+        return list(self)[key]
+
+
 @dataclass
 class Order:
     restaurant_id: int
     order_id: int
     timestamp: float
+    # время обслуживания, заданное заказу заранее (общие случайные числа);
+    # None — его разыгрывает поток оператора в start_service
+    service_time: Optional[float] = None
 
     def __str__(self):
         return f"Order{{restaurant={self.restaurant_id}, id={self.order_id}, time={self.timestamp:.2f}}}"
 
 
 class Buffer:
-    def __init__(self, capacity: int):
+    # Д1ОЗ2 с индексами для Д2Б5: у каждого ресторана своя FIFO-очередь,
+    # общий порядок поступления хранится отдельно (с ленивым удалением),
+    # а битовая маска отмечает рестораны с непустой очередью.
+    # pop_first, pop_first_by_restaurant и выбор ресторана с минимальным
+    # номером — O(1) амортизированно (маска — O(число слов)).
+
+    def __init__(self, capacity: int, num_restaurants: int = 0):
         self.capacity = capacity
-        self.orders: List[Order] = []
+        self._size = 0
+        # элемент очереди — [order, alive]; одна и та же запись лежит
+        # и в очереди ресторана, и в общем порядке поступления
+        self._by_restaurant: List[deque] = [deque() for _ in range(num_restaurants)]
+        self._arrivals: deque = deque()
+        self._present = 0   # бит r — в буфере есть заявки ресторана r
+
+    def __len__(self) -> int:
+        return self._size
+
+    @property
+    def orders(self) -> List[Order]:
+        # заявки в порядке поступления (для вывода состояния)
+        return [entry[0] for entry in self._arrivals if entry[1]]
 
     def is_full(self) -> bool:
-        return len(self.orders) >= self.capacity
+        return self._size >= self.capacity
 
     def is_empty(self) -> bool:
-        return len(self.orders) == 0
+        return self._size == 0
 
     def add_fifo(self, order: Order) -> int:
         if self.is_full():
             return -1
-        self.orders.append(order)
-        return len(self.orders) - 1
+        rid = order.restaurant_id
+        while rid >= len(self._by_restaurant):
+            self._by_restaurant.append(deque())
+        entry = [order, True]
+        self._by_restaurant[rid].append(entry)
+        self._arrivals.append(entry)
+        self._present |= 1 << rid
+        self._size += 1
+        return self._size - 1
 
     def pop_first(self) -> Optional[Order]:
         if self.is_empty():
             return None
-        return self.orders.pop(0)
+        arrivals = self._arrivals
+        while not arrivals[0][1]:
+            arrivals.popleft()
+        entry = arrivals.popleft()
+        # самая ранняя заявка буфера — первая и в очереди своего ресторана
+        return self._take(self._by_restaurant[entry[0].restaurant_id].popleft())
 
     def pop_first_by_restaurant(self, restaurant_id: int) -> Optional[Order]:
-        for i, o in enumerate(self.orders):
-            if o.restaurant_id == restaurant_id:
-                return self.orders.pop(i)
-        return None
+        if not (self._present >> restaurant_id) & 1:
+            return None
+        return self._take(self._by_restaurant[restaurant_id].popleft())
+
+    def lowest_restaurant(self) -> Optional[int]:
+        present = self._present
+        if not present:
+            return None
+        return (present & -present).bit_length() - 1
 
     def restaurants_present(self) -> List[int]:
-        return sorted({o.restaurant_id for o in self.orders})
+        result = []
+        present = self._present
+        while present:
+            low = present & -present
+            result.append(low.bit_length() - 1)
+            present ^= low
+        return result
+
+    def _take(self, entry: list) -> Order:
+        order = entry[0]
+        entry[1] = False
+        self._size -= 1
+        if not self._by_restaurant[order.restaurant_id]:
+            self._present &= ~(1 << order.restaurant_id)
+
+        arrivals = self._arrivals
+        while arrivals and not arrivals[0][1]:
+            arrivals.popleft()
+        # удалённые из середины записи копятся, пока впереди стоит старая
+        # заявка; периодически сжимаем общий порядок (амортизированно O(1))
+        if len(arrivals) > 2 * self._size + 32:
+            self._arrivals = deque(e for e in arrivals if e[1])
+        return order
 
     def __str__(self):
-        if not self.orders:
+        orders = self.orders
+        if not orders:
             return "(пусто)"
-        return "\n".join(f"  [{i}] {o}" for i, o in enumerate(self.orders))
+        return "\n".join(f"  [{i}] {o}" for i, o in enumerate(orders))
+
+
+class RunningStats:
+    # Потоковая статистика по Уэлфорду: число, среднее, дисперсия, min/max
+    # за O(1) памяти. Дисперсия — выборочная по всем наблюдениям (m2 / n),
+    # как и прежняя D[.] = E[x²] - m², но без потери точности на длинных прогонах.
+    __slots__ = ("count", "mean", "m2", "min", "max")
+
+    def __init__(self):
+        self.count = 0
+        self.mean = 0.0
+        self.m2 = 0.0
+        self.min = math.inf
+        self.max = -math.inf
+
+    def add(self, x: float):
+        self.count += 1
+        delta = x - self.mean
+        self.mean += delta / self.count
+        self.m2 += delta * (x - self.mean)
+        if x < self.min:
+            self.min = x
+        if x > self.max:
+            self.max = x
+
+    @property
+    def variance(self) -> float:
+        return self.m2 / self.count if self.count else 0.0
+
+
+class SampledRunningStats(RunningStats):
+    # То же, плюс сырые наблюдения в samples (отладочный режим keep_samples)
+    __slots__ = ("samples",)
+
+    def __init__(self):
+        super().__init__()
+        self.samples: List[float] = []
+
+    def add(self, x: float):
+        RunningStats.add(self, x)
+        self.samples.append(x)
+
+
+class BatchMeans:
+    # Пакетные средние за O(max_batches) памяти. Наблюдения копятся в
+    # текущий пакет, пока его вес не достигнет size; когда полных пакетов
+    # становится max_batches, соседние пары сливаются, а size удваивается.
+    # Так размер пакета сам растёт с длиной прогона, а пакетов всегда от
+    # max_batches / 2 до max_batches. Вес — число наблюдений или длительность
+    # (для средних по времени, как длина буфера).
+    __slots__ = ("max_batches", "size", "sums", "weights", "_sum", "_weight")
+
+    def __init__(self, max_batches: int = 64, size: float = 1.0):
+        # при max_batches полных пакетах они сливаются парами
+        if max_batches < 2 or max_batches % 2:
+            raise ValueError(f"max_batches должно быть чётным и не меньше 2, получено {max_batches}")
+        self.max_batches = max_batches
+        self.size = size
+        self.sums: List[float] = []
+        self.weights: List[float] = []
+        self._sum = 0.0
+        self._weight = 0.0
+
+    def add(self, total: float, weight: float = 1.0):
+        self._sum += total
+        self._weight += weight
+        if self._weight >= self.size:
+            self.sums.append(self._sum)
+            self.weights.append(self._weight)
+            self._sum = 0.0
+            self._weight = 0.0
+            if len(self.sums) == self.max_batches:
+                s, w = self.sums, self.weights
+                self.sums = [s[i] + s[i + 1] for i in range(0, len(s), 2)]
+                self.weights = [w[i] + w[i + 1] for i in range(0, len(w), 2)]
+                self.size *= 2
+
+    def means(self) -> List[float]:
+        return [s / w for s, w in zip(self.sums, self.weights)]
+
+    def total(self) -> Tuple[float, float]:
+        # сумма и вес всех наблюдений, включая неполный текущий пакет
+        return sum(self.sums) + self._sum, sum(self.weights) + self._weight
+
+
+class BatchedRunningStats(RunningStats):
+    # RunningStats ресторана, дублирующий наблюдения в общий приёмник
+    # (пакетные средние, циклы регенерации); шаг SMO при этом не меняется
+    __slots__ = ("_sink",)
+
+    def __init__(self, sink):
+        super().__init__()
+        self._sink = sink
+
+    def add(self, x: float):
+        RunningStats.add(self, x)
+        self._sink(x)
+
+
+class BatchMeansCollector:
+    # Пакетные средние по всей системе: ожидание и пребывание — по
+    # заказам в порядке завершения, длина буфера — по времени (интервалы
+    # между завершениями, площадь из SMO.buffer_area).
+    def __init__(self, smo: "SMO", max_batches: int = 64):
+        self.smo = smo
+        self.wait = BatchMeans(max_batches)
+        self.system = BatchMeans(max_batches)
+        self.buffer = BatchMeans(max_batches)
+        self._area = smo.buffer_area
+        self._time = smo.time
+
+    def add_wait(self, x: float):
+        self.wait.add(x)
+
+    def add_system(self, x: float):
+        self.system.add(x)
+        smo = self.smo
+        self.buffer.add(smo.buffer_area - self._area, smo.time - self._time)
+        self._area = smo.buffer_area
+        self._time = smo.time
+
+    def as_dict(self) -> dict:
+        return {"wait": self.wait, "system": self.system, "buffer": self.buffer}
+
+
+class RatioStats:
+    # Средние и ковариации пары (Y, X) по циклам регенерации (Уэлфорд) —
+    # для отношения E[Y] / E[X] и его доверительного интервала
+    __slots__ = ("count", "mean_y", "mean_x", "cyy", "cxx", "cxy")
+
+    def __init__(self):
+        self.count = 0
+        self.mean_y = 0.0
+        self.mean_x = 0.0
+        self.cyy = 0.0
+        self.cxx = 0.0
+        self.cxy = 0.0
+
+    def add(self, y: float, x: float):
+        self.count += 1
+        dy = y - self.mean_y
+        dx = x - self.mean_x
+        self.mean_y += dy / self.count
+        self.mean_x += dx / self.count
+        self.cyy += dy * (y - self.mean_y)
+        self.cxx += dx * (x - self.mean_x)
+        self.cxy += dx * (y - self.mean_y)
+
+
+# Отношения по циклам: ключи как у smo_replications.METRICS
+REGENERATIVE_METRICS = ("p_reject", "wait_mean", "system_mean", "utilization", "buffer_mean")
+
+
+class RegenerativeCollector:
+    # Суммы по циклам регенерации. Точка регенерации — поступление заказа
+    # ресторана 0 в пустую систему (буфер пуст, все операторы свободны):
+    # поступления детерминированы и в этот момент все источники в одной и
+    # той же фазе, времена обслуживания независимы, а пакет свободного
+    # оператора перезаписывается при следующем же назначении. Все заказы
+    # цикла завершаются до его конца, поэтому ожидание и пребывание
+    # относятся к циклу поступления. Неполный цикл до первой точки (после
+    # reset_statistics) не учитывается.
+    def __init__(self, smo: "SMO"):
+        self.smo = smo
+        self.stats = {key: RatioStats() for key in REGENERATIVE_METRICS}
+        self.started = False
+        self.wait = 0.0     # суммы текущего цикла
+        self.system = 0.0
+        self._generated = 0
+        self._rejected = 0
+        self._processed = 0
+        self._area = 0.0
+        self._time = 0.0
+
+    def add_wait(self, x: float):
+        self.wait += x
+
+    def add_system(self, x: float):
+        self.system += x
+
+    def regenerate(self):
+        # вызывается при поступлении в пустую систему; само поступление
+        # (уже в total_generated) открывает новый цикл
+        smo = self.smo
+        generated = smo.total_generated - 1
+        if self.started:
+            tau = smo.time - self._time
+            processed = smo.total_processed - self._processed
+            st = self.stats
+            st["p_reject"].add(smo.total_rejected - self._rejected, generated - self._generated)
+            st["wait_mean"].add(self.wait, processed)
+            st["system_mean"].add(self.system, processed)
+            st["utilization"].add(self.system - self.wait, len(smo.operators) * tau)
+            st["buffer_mean"].add(smo.buffer_area - self._area, tau)
+        self.started = True
+        self.wait = 0.0
+        self.system = 0.0
+        self._generated = generated
+        self._rejected = smo.total_rejected
+        self._processed = smo.total_processed
+        self._area = smo.buffer_area
+        self._time = smo.time
 
 
 class RestaurantSource:
@@ -98,10 +660,177 @@ class RestaurantSource:
         return ev
 
 
+class ReplaySource(RestaurantSource):
+    # Источник ресторана при SMO(arrivals=...): поступления всех ресторанов
+    # идут из одного журнала (smo_replay.ArrivalLog) в порядке времени, в
+    # календаре всегда одно будущее поступление. generate_event любого
+    # источника берёт следующую запись журнала (её ресторан может быть
+    # другим); номер заказа — счётчик ресторана записи.
+    def __init__(self, restaurant_id: int, arrivals):
+        super().__init__(restaurant_id, 0.0, math.inf)
+        self.arrivals = arrivals
+
+    def generate_event(self) -> Optional[Event]:
+        return self.arrivals.next_event()
+
+
+class RegenerationSource(RestaurantSource):
+    # Источник ресторана 0 при SMO(regenerative=True): шаг SMO вызывает
+    # generate_event в момент поступления, до его обработки, — там и
+    # проверяется точка регенерации; остальные источники и шаг не меняются
+    def __init__(self, restaurant_id: int, interval: float, start_offset: float = 0.0):
+        super().__init__(restaurant_id, interval, start_offset)
+        self.on_arrival = None
+
+    def generate_event(self) -> Event:
+        if self.on_arrival is not None:
+            self.on_arrival()
+        return RestaurantSource.generate_event(self)
+
+
+MASK64 = (1 << 64) - 1
+GOLDEN_GAMMA = 0x9E3779B97F4A7C15
+
+
+def splitmix64(x: int) -> int:
+    # Финализатор SplitMix64: биективно перемешивает 64-битное слово
+    z = (x + GOLDEN_GAMMA) & MASK64
+    z = ((z ^ (z >> 30)) * 0xBF58476D1CE4E5B9) & MASK64
+    z = ((z ^ (z >> 27)) * 0x94D049BB133111EB) & MASK64
+    return z ^ (z >> 31)
+
+
+def split_key(key: int, index: int) -> int:
+    # Ключ дочернего потока index; разные index дают независимые потоки
+    return splitmix64(key ^ splitmix64(index & MASK64))
+
+
+# Дочерние потоки корневого ключа прогона (seed):
+# split_key(split_key(seed, STREAM_OPERATOR), i) — обслуживание оператором i;
+# split_key(split_key(seed, STREAM_RESTAURANT), i) — времена обслуживания
+# заказов ресторана i в режиме общих случайных чисел (crn).
+STREAM_OPERATOR = 1
+STREAM_RESTAURANT = 2
+
+# Антитетичная пара к u = k / 2**53 — (2**53 - 1 - k) / 2**53 = ANTITHETIC_ONE - u:
+# разность вычисляется точно и переставляет значения random() между собой
+ANTITHETIC_ONE = 1.0 - 2.0 ** -53
+
+
+class RandomStream:
+    # Поток случайных чисел с ключом key: MT19937 модуля random, засеянный
+    # один раз значением splitmix64(key). Позиция потока — явный номер
+    # значения drawn (tell/seek), потоки дёшево делятся (split) и не зависят
+    # друг от друга. Генератор создаётся при первом обращении; после seek(n)
+    # он засевается заново и пропускает n значений через getrandbits — в C,
+    # поэтому восстановление снимка линейно по числу выданных значений, но
+    # дёшево.
+
+    SKIP = 1 << 16   # значений, пропускаемых одним вызовом getrandbits
+    __slots__ = ("key", "antithetic", "drawn", "_gen")
+
+    def __init__(self, key: int, antithetic: bool = False):
+        self.key = key & MASK64
+        self.antithetic = antithetic  # u заменяется на ANTITHETIC_ONE - u
+        self.drawn = 0                # сколько значений уже выдано
+        self._gen: Optional[random.Random] = None
+
+    def split(self, index: int) -> "RandomStream":
+        # дочерний поток того же вида (равномерный / экспоненциальный)
+        return type(self)(split_key(self.key, index), self.antithetic)
+
+    def next(self) -> float:
+        gen = self._gen or self._generator()
+        self.drawn += 1
+        u = gen.random()
+        return ANTITHETIC_ONE - u if self.antithetic else u
+
+    def tell(self) -> int:
+        return self.drawn
+
+    def seek(self, n: int):
+        # следующим будет n-е значение; генератор догоняет позицию лениво
+        self.drawn = n
+        self._gen = None
+
+    def _generator(self) -> random.Random:
+        gen = self._gen = random.Random(splitmix64(self.key))
+        # random() берёт два 32-битных слова, getrandbits(64 * k) — 2k слов
+        for done in range(0, self.drawn, self.SKIP):
+            gen.getrandbits(64 * min(self.SKIP, self.drawn - done))
+        return gen
+
+    random = next
+
+
+class ExponentialStream(RandomStream):
+    # Поток Exp(1): next() = -log(1 - u). Для обслуживания П32 есть быстрый
+    # путь expovariate(rate) — тот же random.Random.expovariate на генераторе
+    # потока, побитово равный next() / rate. Он не считает значения: вызывающий
+    # увеличивает drawn после вызова (Operator.start_service, crn в SMO._arrive).
+    # Готовые блоки Exp(1) здесь не быстрее: значение в любом случае стоит
+    # вызова random() и log из Python, а заполнение блока добавляет цикл
+    # интерпретатора (замер — bench_smo.py); блоки считает нативный движок.
+
+    __slots__ = ("expovariate",)
+
+    def __init__(self, key: int, antithetic: bool = False):
+        super().__init__(key, antithetic)
+        self.expovariate = self._first_expovariate
+
+    def next(self) -> float:
+        return -math.log(1.0 - RandomStream.next(self))
+
+    def seek(self, n: int):
+        super().seek(n)
+        self.expovariate = self._first_expovariate
+
+    def _first_expovariate(self, rate: float) -> float:
+        # первое обращение: засев и выбор быстрого пути
+        gen = self._gen or self._generator()
+        if self.antithetic:
+            rnd, log = gen.random, math.log
+            self.expovariate = lambda rate: -log(1.0 - (ANTITHETIC_ONE - rnd())) / rate
+        else:
+            self.expovariate = gen.expovariate
+        return self.expovariate(rate)
+
+
+class FreeOperatorIndex:
+    # Множество свободных операторов для Д2П1: бит i установлен, если
+    # оператор i свободен; "свободный с минимальным номером" — младший бит.
+
+    def __init__(self, num_operators: int):
+        self._all = (1 << num_operators) - 1
+        self._bits = self._all
+
+    def all_free(self) -> bool:
+        return self._bits == self._all
+
+    def acquire(self, operator_id: int):
+        self._bits &= ~(1 << operator_id)
+
+    def release(self, operator_id: int):
+        self._bits |= 1 << operator_id
+
+    def lowest(self) -> int:
+        bits = self._bits
+        if not bits:
+            return -1
+        return (bits & -bits).bit_length() - 1
+
+
 class Operator:
-    def __init__(self, operator_id: int, mean_service_time: float):
+    def __init__(self, operator_id: int, mean_service_time: float,
+                 free_index: Optional[FreeOperatorIndex] = None,
+                 stream: Optional[ExponentialStream] = None):
         self.operator_id = operator_id
         self.mean_service_time = mean_service_time
+        self.free_index = free_index
+        # собственный поток оператора: его времена обслуживания не зависят
+        # от числа остальных операторов и ресторанов
+        self.stream = stream if stream is not None else ExponentialStream(operator_id)
+        self._rate = 1.0 / mean_service_time
         self.busy = False
         self.current_order: Optional[Order] = None
         self.batch_restaurant_id: Optional[int] = None
@@ -112,13 +841,20 @@ class Operator:
 
     def start_service(self, order: Order, current_time: float) -> Event:
         self.busy = True
+        if self.free_index is not None:
+            self.free_index.acquire(self.operator_id)
         self.current_order = order
         self.batch_restaurant_id = order.restaurant_id
 
         # для загрузки прибора
         self.last_start_time = current_time
 
-        dt = random.expovariate(1.0 / self.mean_service_time)  # П32
+        # П32: random.expovariate на собственном потоке оператора
+        dt = order.service_time
+        if dt is None:
+            stream = self.stream
+            dt = stream.expovariate(self._rate)
+            stream.drawn += 1
         finish_time = current_time + dt
         wait_time = current_time - order.timestamp
         return Event(
@@ -137,6 +873,8 @@ class Operator:
         self.busy = False
         self.current_order = None
         self.last_start_time = None
+        if self.free_index is not None:
+            self.free_index.release(self.operator_id)
 
 
 class SMO:
@@ -147,49 +885,105 @@ class SMO:
         interval: float = 0.2,   # средний интервал (интенсивность ~ 1/interval)
         op_mean: float = 2.0,
         buffer_cap: int = 100,
-        seed: Optional[int] = 1
+        seed: Optional[int] = 1,
+        event_set: str = "heap",  # "heap" | "calendar" | "indexed"
+        log_capacity: int = 1000, # сколько последних событий хранит журнал
+        trace: TraceLevel = TraceLevel.FULL,
+        keep_samples: bool = False,  # хранить сырые T ожидания/пребывания (отладка)
+        crn: bool = False,         # времена обслуживания по заказам (общие случайные числа)
+        antithetic: bool = False,  # антитетичный прогон: все потоки на 1 - u
+        batch_means: bool = False,  # пакетные средние для интервалов по одному прогону
+        regenerative: bool = False,  # суммы по циклам регенерации (пустая система)
+        trace_sink=None,           # приёмник журнала: write(ev), см. smo_trace.TraceWriter
+        arrivals=None              # журнал поступлений вместо interval, см. smo_replay.ArrivalLog
     ):
-        if seed is not None:
-            random.seed(seed)
+        if event_set not in EVENT_SETS:
+            raise ValueError(f"неизвестный календарь событий: {event_set!r}")
+        if (batch_means or regenerative) and keep_samples:
+            raise ValueError("batch_means и regenerative не совмещаются с keep_samples")
+        if arrivals is not None and (crn or regenerative):
+            raise ValueError("arrivals не совмещается с crn и regenerative")
+        if seed is None:
+            seed = random.getrandbits(64)
+        self.seed = seed & MASK64
+        self.interval = interval
+        self.op_mean = op_mean
+        self.crn = crn
+        self.antithetic = antithetic
+        operator_streams = ExponentialStream(split_key(self.seed, STREAM_OPERATOR), antithetic)
 
         self.time = 0.0
-        self.buffer = Buffer(buffer_cap)
-        self.operators = [Operator(i, op_mean) for i in range(num_operators)]
+        self.buffer = Buffer(buffer_cap, num_restaurants)
+        self.free_operators = FreeOperatorIndex(num_operators)
+        self.operators = [Operator(i, op_mean, self.free_operators, operator_streams.split(i))
+                          for i in range(num_operators)]
 
         self.restaurants: List[RestaurantSource] = []
+        self.arrivals = arrivals
         for i in range(num_restaurants):
+            if arrivals is not None:
+                self.restaurants.append(ReplaySource(i, arrivals))
+                continue
             start_offset = (i * interval) / num_restaurants
-            self.restaurants.append(RestaurantSource(i, interval, start_offset))
-
-        self.event_queue: List[Event] = []
-        self.last_events: List[Event] = []
+            source_type = RegenerationSource if regenerative and i == 0 else RestaurantSource
+            self.restaurants.append(source_type(i, interval, start_offset))
+        if arrivals is not None:
+            arrivals.bind(self.restaurants)
+
+        # crn: заказ k ресторана i получает k-е значение потока ресторана при
+        # поступлении (даже если получит отказ), поэтому у сравниваемых
+        # конфигураций с тем же seed одни и те же заказы обслуживаются одинаково
+        restaurant_streams = ExponentialStream(split_key(self.seed, STREAM_RESTAURANT), antithetic)
+        self._order_streams = [restaurant_streams.split(i) for i in range(num_restaurants)] if crn else None
+        self._order_rate = 1.0 / op_mean
+
+        self.event_set = event_set
+        self.event_queue = EVENT_SETS[event_set](num_restaurants, num_operators)
+        self._next_seq = 0   # третья позиция ключа события (см. push_event), входит в снимок
+        self.last_events = EventLog(log_capacity)
+        self._n_to_operator = 0
+        self._n_to_buffer = 0
+        self._setup_trace(trace, trace_sink)
 
         # --- старая статистика ---
         self.total_generated = 0
         self.total_processed = 0
         self.total_rejected = 0
-        self.wait_times = [[] for _ in range(num_restaurants)]
+        stats_type = SampledRunningStats if keep_samples else RunningStats
+        self._stats_type = stats_type
+        self._batch_means_enabled = batch_means
+        self.batch_collector: Optional[BatchMeansCollector] = None
+        self._regenerative = regenerative
+        self.regen_collector: Optional[RegenerativeCollector] = None
+        self.stats_start = 0.0   # с какого момента копится статистика (reset_statistics)
+        self._generated_base = [0] * num_restaurants
 
         # --- новая статистика (дополнительно) ---
         self.rejected_by_restaurant = [0] * num_restaurants
-        self.system_times = [[] for _ in range(num_restaurants)]  # T пребывания в системе
 
         # средняя длина буфера (интеграл длины)
         self.buffer_area = 0.0
         self.last_event_time = 0.0
 
-        for r in self.restaurants:
-            heapq.heappush(self.event_queue, r.generate_event())
+        # T ожидания и T пребывания в системе по ресторанам
+        self.wait_stats, self.system_stats = self._new_stats(num_restaurants)
+
+        if arrivals is not None:
+            first = arrivals.next_event()
+            if first is not None:
+                self.push_event(first)
+        else:
+            for r in self.restaurants:
+                self.push_event(r.generate_event())
+        if regenerative and self.restaurants:
+            self.restaurants[0].on_arrival = self._check_regeneration
 
     def _get_free_operator_d2p1(self) -> Optional[Operator]:
-        free_ops = [op for op in self.operators if not op.busy]
-        if not free_ops:
-            return None
-        return min(free_ops, key=lambda o: o.operator_id)
+        op_id = self.free_operators.lowest()
+        return self.operators[op_id] if op_id >= 0 else None
 
     def _select_restaurant_for_batch(self) -> Optional[int]:
-        rests = self.buffer.restaurants_present()
-        return rests[0] if rests else None
+        return self.buffer.lowest_restaurant()
 
     def _take_order_from_buffer_d2b5(self, op: Operator) -> Optional[Order]:
         if self.buffer.is_empty():
@@ -205,88 +999,200 @@ class SMO:
         return self.buffer.pop_first_by_restaurant(new_rest)
 
     def push_event(self, ev: Event):
-        heapq.heappush(self.event_queue, ev)
+        prio = PRIO_COMPLETION if ev.etype is EventType.OPERATOR_FREE else PRIO_ARRIVAL
+        seq = self._next_seq
+        self._next_seq = seq + 1
+        self.event_queue.push((ev.time, prio, seq, ev))
+
+    def _setup_trace(self, trace: TraceLevel, sink=None):
+        # Уровень трассировки выбирается один раз: при OFF шаг подменяется
+        # специализированной версией без обращений к журналу, иначе хуки
+        # связываются с нужными реализациями (без проверок уровня на событие).
+        # sink получает каждое событие журнала (уровни REJECTS и FULL).
+        self.trace = trace
+        self.trace_sink = sink
+        if sink is not None:
+            if trace not in (TraceLevel.REJECTS, TraceLevel.FULL):
+                raise ValueError("trace_sink требует уровня трассировки REJECTS или FULL")
+            self._sink_write = sink.write
+            self._log = self._log_to_sink
+        if trace is TraceLevel.OFF:
+            self.step = self._step_untraced
+            return
+        self.step = self._step_traced
+        if trace is TraceLevel.FULL:
+            self._trace_popped = self._log
+            self._trace_to_operator = self._log_to_operator
+            self._trace_to_buffer = self._log_to_buffer
+            self._trace_rejected = self._log_rejected
+        elif trace is TraceLevel.REJECTS:
+            self._trace_popped = self._trace_nothing
+            self._trace_to_operator = self._trace_nothing
+            self._trace_to_buffer = self._trace_nothing
+            self._trace_rejected = self._log_rejected
+        else:
+            self._trace_popped = self._trace_nothing
+            self._trace_to_operator = self._count_to_operator
+            self._trace_to_buffer = self._count_to_buffer
+            self._trace_rejected = self._trace_nothing
+
+    def set_trace(self, trace: TraceLevel):
+        # Смена уровня трассировки между шагами; приёмник журнала сохраняется
+        self._setup_trace(trace, self.trace_sink)
+
+    def _trace_nothing(self, *args):
+        pass
 
     def _log(self, ev: Event):
         self.last_events.append(ev)
 
-    def step(self) -> bool:
-        if not self.event_queue:
-            return False
+    def _log_to_sink(self, ev: Event):
+        self.last_events.append(ev)
+        self._sink_write(ev)
+
+    def _log_to_operator(self, order: Order, op: Operator, wait_time: float):
+        self._log(Event(
+            time=self.time,
+            etype=EventType.ORDER_TO_OPERATOR,
+            restaurant_id=order.restaurant_id,
+            order_id=order.order_id,
+            operator_id=op.operator_id,
+            wait_time=wait_time
+        ))
 
-        ev = heapq.heappop(self.event_queue)
+    def _log_to_buffer(self, order: Order, pos: int):
+        self._log(Event(
+            time=self.time,
+            etype=EventType.ORDER_TO_BUFFER,
+            restaurant_id=order.restaurant_id,
+            order_id=order.order_id,
+            buffer_pos=pos
+        ))
+
+    def _log_rejected(self, order: Order):
+        self._log(Event(
+            time=self.time,
+            etype=EventType.ORDER_REJECTED,
+            restaurant_id=order.restaurant_id,
+            order_id=order.order_id
+        ))
+
+    def _count_to_operator(self, order: Order, op: Operator, wait_time: float):
+        self._n_to_operator += 1
+
+    def _count_to_buffer(self, order: Order, pos: int):
+        self._n_to_buffer += 1
+
+    def event_counts(self) -> dict:
+        # счётчики уровня COUNTERS (на других уровнях ORDER_TO_* не считаются)
+        return {
+            EventType.ORDER_GENERATED: self.total_generated,
+            EventType.ORDER_TO_OPERATOR: self._n_to_operator,
+            EventType.ORDER_TO_BUFFER: self._n_to_buffer,
+            EventType.OPERATOR_FREE: self.total_processed,
+            EventType.ORDER_REJECTED: self.total_rejected,
+        }
+
+    # Переходы состояния шага — общие для всех уровней трассировки; шаги
+    # ниже различаются только вызовами хуков журнала.
+    def _advance(self) -> Optional[Event]:
+        # следующее событие календаря (None — календарь пуст) и сдвиг времени
+        if not self.event_queue:
+            return None
+        ev = self.event_queue.pop()
 
         # --- средняя длина буфера: накапливаем площадь len(buffer)*dt ---
         dt = ev.time - self.last_event_time
         if dt > 0:
-            self.buffer_area += len(self.buffer.orders) * dt
+            self.buffer_area += len(self.buffer) * dt
             self.last_event_time = ev.time
 
         self.time = ev.time
-        self._log(ev)
+        return ev
+
+    def _arrive(self, ev: Event) -> Tuple[Order, Optional[Operator]]:
+        # поступление: следующее поступление в календарь, новый заказ и
+        # свободный оператор для него (None — все заняты)
+        self.total_generated += 1
+        rest = self.restaurants[ev.restaurant_id]
+        nxt = rest.generate_event()
+        if nxt is not None:   # None — журнал воспроизведения кончился
+            self.push_event(nxt)
+
+        order = Order(ev.restaurant_id, ev.order_id, ev.time)
+        if self.crn:
+            stream = self._order_streams[ev.restaurant_id]
+            order.service_time = stream.expovariate(self._order_rate)
+            stream.drawn += 1
+        elif self.arrivals is not None:
+            order.service_time = ev.service_time
+        return order, self._get_free_operator_d2p1()
+
+    def _reject(self, order: Order):
+        self.total_rejected += 1
+        self.rejected_by_restaurant[order.restaurant_id] += 1
+
+    def _complete(self, ev: Event) -> Tuple[Operator, Optional[Order]]:
+        # завершение обслуживания: статистика, освобождение оператора и
+        # следующий заказ ему из буфера (None — подходящего нет)
+        op = self.operators[ev.operator_id]
+
+        # --- корректное T пребывания: берём timestamp у текущей заявки прибора ---
+        finished_order = op.current_order
+        if finished_order is not None:
+            system_time = self.time - finished_order.timestamp
+            self.system_stats[finished_order.restaurant_id].add(system_time)
+
+        op.free(self.time)
+
+        self.total_processed += 1
+        self.wait_stats[ev.restaurant_id].add(ev.wait_time)
+        return op, self._take_order_from_buffer_d2b5(op)
+
+    def _step_traced(self) -> bool:
+        ev = self._advance()
+        if ev is None:
+            return False
+        self._trace_popped(ev)
+
+        if ev.etype is EventType.ORDER_GENERATED:
+            order, op = self._arrive(ev)
+            if op is not None:
+                self._trace_to_operator(order, op, 0.0)
+                self.push_event(op.start_service(order, self.time))
+            elif not self.buffer.is_full():
+                pos = self.buffer.add_fifo(order)
+                self._trace_to_buffer(order, pos)
+            else:
+                self._reject(order)
+                self._trace_rejected(order)
 
-        if ev.etype == EventType.ORDER_GENERATED:
-            self.total_generated += 1
-            rest = self.restaurants[ev.restaurant_id]
-            self.push_event(rest.generate_event())
+        elif ev.etype is EventType.OPERATOR_FREE:
+            op, order = self._complete(ev)
+            if order is not None:
+                self._trace_to_operator(order, op, self.time - order.timestamp)
+                self.push_event(op.start_service(order, self.time))
 
-            order = Order(ev.restaurant_id, ev.order_id, ev.time)
-            op = self._get_free_operator_d2p1()
+        return True
+
+    # Тот же шаг, что _step_traced, но без хуков трассировки (TraceLevel.OFF).
+    def _step_untraced(self) -> bool:
+        ev = self._advance()
+        if ev is None:
+            return False
 
+        if ev.etype is EventType.ORDER_GENERATED:
+            order, op = self._arrive(ev)
             if op is not None:
-                self._log(Event(
-                    time=self.time,
-                    etype=EventType.ORDER_TO_OPERATOR,
-                    restaurant_id=order.restaurant_id,
-                    order_id=order.order_id,
-                    operator_id=op.operator_id,
-                    wait_time=0.0
-                ))
                 self.push_event(op.start_service(order, self.time))
+            elif not self.buffer.is_full():
+                self.buffer.add_fifo(order)
             else:
-                if not self.buffer.is_full():
-                    pos = self.buffer.add_fifo(order)
-                    self._log(Event(
-                        time=self.time,
-                        etype=EventType.ORDER_TO_BUFFER,
-                        restaurant_id=order.restaurant_id,
-                        order_id=order.order_id,
-                        buffer_pos=pos
-                    ))
-                else:
-                    self.total_rejected += 1
-                    self.rejected_by_restaurant[order.restaurant_id] += 1
-                    self._log(Event(
-                        time=self.time,
-                        etype=EventType.ORDER_REJECTED,
-                        restaurant_id=order.restaurant_id,
-                        order_id=order.order_id
-                    ))
-
-        elif ev.etype == EventType.OPERATOR_FREE:
-            op = self.operators[ev.operator_id]
-
-            # --- корректное T пребывания: берём timestamp у текущей заявки прибора ---
-            finished_order = op.current_order
-            if finished_order is not None:
-                system_time = self.time - finished_order.timestamp
-                self.system_times[finished_order.restaurant_id].append(system_time)
-
-            op.free(self.time)
-
-            self.total_processed += 1
-            self.wait_times[ev.restaurant_id].append(ev.wait_time)
-
-            order = self._take_order_from_buffer_d2b5(op)
+                self._reject(order)
+
+        elif ev.etype is EventType.OPERATOR_FREE:
+            op, order = self._complete(ev)
             if order is not None:
-                self._log(Event(
-                    time=self.time,
-                    etype=EventType.ORDER_TO_OPERATOR,
-                    restaurant_id=order.restaurant_id,
-                    order_id=order.order_id,
-                    operator_id=op.operator_id,
-                    wait_time=self.time - order.timestamp
-                ))
                 self.push_event(op.start_service(order, self.time))
 
         return True
@@ -296,10 +1202,18 @@ class SMO:
         print(f"Время: {self.time:.2f}")
 
         print("\nРестораны (ИБ + ИЗ1):")
+        if self.arrivals is not None:
+            # у источников журнала нет своего next_time: ожидает одно поступление на всех
+            ev = self.arrivals.pending
+            upcoming = "журнал исчерпан" if ev is None else f"ресторан {ev.restaurant_id}, t={ev.time:.2f}"
+            print(f"  Поступления из журнала: прочитано {self.arrivals.records}, следующее — {upcoming}")
         for r in self.restaurants:
-            print(f"  Ресторан {r.restaurant_id}: interval={r.interval:.2f}, next={r.next_time:.2f}, generated={r.generated}")
+            if isinstance(r, ReplaySource):
+                print(f"  Ресторан {r.restaurant_id}: из журнала, generated={r.generated}")
+            else:
+                print(f"  Ресторан {r.restaurant_id}: interval={r.interval:.2f}, next={r.next_time:.2f}, generated={r.generated}")
 
-        print(f"\nБуфер (Д1ОЗ2): {len(self.buffer.orders)}/{self.buffer.capacity}")
+        print(f"\nБуфер (Д1ОЗ2): {len(self.buffer)}/{self.buffer.capacity}")
         print(self.buffer)
 
         print("\nОператоры (П32):")
@@ -311,86 +1225,201 @@ class SMO:
                 print(f"  Оператор {op.operator_id}: свободен, batch={op.batch_restaurant_id}")
 
 
-    def print_statistics(self):
-        print("\n" + "=" * 70)
-        print("СТАТИСТИКА СИСТЕМЫ (ОР1)")
-        print("=" * 70)
-
-        print(f"Всего заказов (сгенерировано): {self.total_generated}")
-        print(f"Обработано:                 {self.total_processed}")
-        print(f"Отклонено:                  {self.total_rejected}")
-        if self.total_generated > 0:
-            print(f"Процент отказа:             {(self.total_rejected / self.total_generated) * 100:.2f}%")
-
-        print("\nПо ресторанам:")
-        for i, waits in enumerate(self.wait_times):
-            avg_wait = sum(waits) / len(waits) if waits else 0.0
-            print(f"  Ресторан {i}: обработано={len(waits)}, ср. ожидание={avg_wait:.2f}")
+    def _new_stats(self, n: int) -> tuple:
+        # накопители T ожидания и T пребывания по ресторанам; с batch_means
+        # они же кормят общий BatchMeansCollector
+        collectors = []
+        if self._batch_means_enabled:
+            self.batch_collector = BatchMeansCollector(self)
+            collectors.append(self.batch_collector)
+        if self._regenerative:
+            self.regen_collector = RegenerativeCollector(self)
+            collectors.append(self.regen_collector)
+        if not collectors:
+            return ([self._stats_type() for _ in range(n)],
+                    [self._stats_type() for _ in range(n)])
+        if len(collectors) == 1:
+            add_wait, add_system = collectors[0].add_wait, collectors[0].add_system
+        else:
+            a, b = collectors
+
+            def add_wait(x: float):
+                a.add_wait(x)
+                b.add_wait(x)
+
+            def add_system(x: float):
+                a.add_system(x)
+                b.add_system(x)
+        return ([BatchedRunningStats(add_wait) for _ in range(n)],
+                [BatchedRunningStats(add_system) for _ in range(n)])
+
+    def _check_regeneration(self):
+        if self.buffer.is_empty() and self.free_operators.all_free():
+            self.regen_collector.regenerate()
+
+    def regenerative(self) -> dict:
+        # {показатель: RatioStats} по законченным циклам (см. smo_regenerative)
+        if self.regen_collector is None:
+            raise ValueError("циклы регенерации не включены (SMO(regenerative=True))")
+        return self.regen_collector.stats
+
+    def batch_means(self) -> dict:
+        # {"wait" | "system" | "buffer": BatchMeans} (см. smo_batch_means)
+        if self.batch_collector is None:
+            raise ValueError("пакетные средние не включены (SMO(batch_means=True))")
+        return self.batch_collector.as_dict()
+
+    def run_until(self, t_max: float, max_events: Optional[int] = None) -> int:
+        # шаги, пока time < t_max (как NativeSMO.run_until); число событий.
+        # max_events — не больше стольких событий (прогон между снимками)
+        step = self.step
+        events = 0
+        if max_events is None:
+            while self.time < t_max and step():
+                events += 1
+            return events
+        while events < max_events and self.time < t_max and step():
+            events += 1
+        return events
+
+    def reset_statistics(self):
+        # Отсечение разгона: вся статистика начинает копиться заново с
+        # текущего момента, состояние модели (календарь, буфер, занятые
+        # приборы, потоки) не меняется. Заказы, поступившие до сброса,
+        # учитываются при завершении, как и у любого прогона с непустым стартом.
+        n = len(self.restaurants)
+        self.stats_start = self.time
+        self.total_generated = 0
+        self.total_processed = 0
+        self.total_rejected = 0
+        self._n_to_operator = 0
+        self._n_to_buffer = 0
+        self._generated_base = [src.generated for src in self.restaurants]
+        self.rejected_by_restaurant = [0] * n
+        self.buffer_area = 0.0
+        self.last_event_time = self.time
+        self.wait_stats, self.system_stats = self._new_stats(n)
+        for op in self.operators:
+            op.busy_time = 0.0
+            if op.last_start_time is not None:
+                op.last_start_time = self.time
+
+    def summary(self) -> dict:
+        # Итоговые показатели прогона в виде, общем для Python- и нативного
+        # движка (см. smo_native.NativeSMO.summary): по ним печатается статистика.
+        def lo(st: RunningStats) -> float:
+            return st.min if st.count else 0.0
+
+        def hi(st: RunningStats) -> float:
+            return st.max if st.count else 0.0
+
+        return {
+            "time": self.time,
+            "stats_start": self.stats_start,
+            "total_generated": self.total_generated,
+            "total_processed": self.total_processed,
+            "total_rejected": self.total_rejected,
+            "generated": [src.generated - base for src, base in zip(self.restaurants, self._generated_base)],
+            "rejected": list(self.rejected_by_restaurant),
+            "processed": [w.count for w in self.wait_stats],
+            "wait_mean": [w.mean for w in self.wait_stats],
+            "wait_var": [w.variance for w in self.wait_stats],
+            "wait_min": [lo(w) for w in self.wait_stats],
+            "wait_max": [hi(w) for w in self.wait_stats],
+            "system_mean": [t.mean for t in self.system_stats],
+            "system_var": [t.variance for t in self.system_stats],
+            "system_min": [lo(t) for t in self.system_stats],
+            "system_max": [hi(t) for t in self.system_stats],
+            "busy_time": [op.busy_time for op in self.operators],
+            "buffer_area": self.buffer_area,
+        }
 
+    def print_statistics(self):
+        print_statistics(self.summary())
 
     def print_extended_statistics(self):
-        print("\n" + "=" * 70)
-        print("РАСШИРЕННАЯ СТАТИСТИКА")
-        print("=" * 70)
-
-        def mean(xs: List[float]) -> float:
-            return sum(xs) / len(xs) if xs else 0.0
-
-        def var(xs: List[float]) -> float:
-            if not xs:
-                return 0.0
-            m = mean(xs)
-            return (sum(x * x for x in xs) / len(xs)) - (m * m)
-
-        print("\nПо источникам (ресторанам):")
-        for i, src in enumerate(self.restaurants):
-            gen_i = src.generated
-            rej_i = self.rejected_by_restaurant[i]
-            p_rej = (rej_i / gen_i) if gen_i > 0 else 0.0
-
-            w = self.wait_times[i]
-            t = self.system_times[i]
-
-            print(
-                f"  Источник {i}: "
-                f"заявок={gen_i}, "
-                f"отказов={rej_i}, "
-                f"Pотк={p_rej:.3f}, "
-                f"E[Tож]={mean(w):.2f}, D[Tож]={var(w):.2f}, "
-                f"E[Tпр]={mean(t):.2f}, D[Tпр]={var(t):.2f}"
-            )
-
-        print("\nЗагрузка приборов (Kисп и процент загрузки):")
-        T = self.time if self.time > 0 else 1.01
-        for op in self.operators:
-            k = op.busy_time / T
-            percent = k * 100
-            print(
-                f"  Прибор {op.operator_id}: "
-                f"Kисп={k:.3f}, "
-                f"загрузка={percent:.1f}%"
-            )
-
-        avg_buf = (self.buffer_area / T) if T > 0 else 0.0
-        print(f"\nСредняя длина буфера: {avg_buf:.2f}")
+        print_extended_statistics(self.summary())
 
     def print_calendar(self, last_n: int = 80):
+        if self.trace is TraceLevel.COUNTERS:
+            print("\n=== Счётчики событий ===")
+            for etype, n in self.event_counts().items():
+                print(f"  {etype.name}: {n}")
+            return
         print("\n=== Последние события (ОД3) ===")
         tail = self.last_events[-last_n:] if last_n > 0 else self.last_events
         for ev in tail:
             print(ev)
 
 
+def print_statistics(s: dict):
+    print("\n" + "=" * 70)
+    print("СТАТИСТИКА СИСТЕМЫ (ОР1)")
+    print("=" * 70)
+
+    print(f"Всего заказов (сгенерировано): {s['total_generated']}")
+    print(f"Обработано:                 {s['total_processed']}")
+    print(f"Отклонено:                  {s['total_rejected']}")
+    if s["total_generated"] > 0:
+        print(f"Процент отказа:             {(s['total_rejected'] / s['total_generated']) * 100:.2f}%")
+
+    print("\nПо ресторанам:")
+    for i, (n, avg_wait) in enumerate(zip(s["processed"], s["wait_mean"])):
+        print(f"  Ресторан {i}: обработано={n}, ср. ожидание={avg_wait:.2f}")
+
+
+def print_extended_statistics(s: dict):
+    print("\n" + "=" * 70)
+    print("РАСШИРЕННАЯ СТАТИСТИКА")
+    print("=" * 70)
+    if s.get("stats_start", 0.0) > 0:
+        print(f"(разгон отсечён: статистика с t={s['stats_start']:.2f})")
+
+    print("\nПо источникам (ресторанам):")
+    for i, gen_i in enumerate(s["generated"]):
+        rej_i = s["rejected"][i]
+        p_rej = (rej_i / gen_i) if gen_i > 0 else 0.0
+
+        print(
+            f"  Источник {i}: "
+            f"заявок={gen_i}, "
+            f"отказов={rej_i}, "
+            f"Pотк={p_rej:.3f}, "
+            f"E[Tож]={s['wait_mean'][i]:.2f}, D[Tож]={s['wait_var'][i]:.2f}, "
+            f"E[Tпр]={s['system_mean'][i]:.2f}, D[Tпр]={s['system_var'][i]:.2f}"
+        )
+
+    print("\nЗагрузка приборов (Kисп и процент загрузки):")
+    T = s["time"] - s.get("stats_start", 0.0)
+    T = T if T > 0 else 1.01
+    for op_id, busy_time in enumerate(s["busy_time"]):
+        k = busy_time / T
+        percent = k * 100
+        print(
+            f"  Прибор {op_id}: "
+            f"Kисп={k:.3f}, "
+            f"загрузка={percent:.1f}%"
+        )
+
+    avg_buf = (s["buffer_area"] / T) if T > 0 else 0.0
+    print(f"\nСредняя длина буфера: {avg_buf:.2f}")
+
+
 def main():
     print("=== СИМУЛЯЦИЯ СМО - ЦЕНТР ОБРАБОТКИ ЗАКАЗОВ ДОСТАВКИ ЕДЫ ===")
 
+    # Одна модель на все режимы меню: пошаговый режим идёт с журналом
+    # (FULL), автоматический — без него (OFF, по bench_smo.py быстрее FULL
+    # в 1.2–1.35 раза на main/default), поэтому календарь событий показывает
+    # только события пошагового режима.
     smo = SMO(
         num_restaurants=15,
         num_operators=5,
         interval=10.0,
         op_mean=2.0,
         buffer_cap=3,
-        seed=1
+        seed=1,
+        trace=TraceLevel.FULL
     )
 
     while True:
@@ -413,8 +1442,10 @@ def main():
 
         elif cmd == "2":
             t_max = float(input("До какого времени моделировать? "))
+            smo.set_trace(TraceLevel.OFF)
             while smo.time < t_max and smo.step():
                 pass
+            smo.set_trace(TraceLevel.FULL)
             print("\nАвтоматическая симуляция завершена.")
             smo.print_statistics()            # старая статистика
             smo.print_extended_statistics()   # новая расширенная
@@ -0,0 +1,132 @@
+import argparse
+import os
+import time
+from concurrent.futures import ProcessPoolExecutor
+from typing import Dict, List, Optional
+
+from smo_checkpoint import dumps, loads, with_changes
+from smo_food_center import SMO, TraceLevel
+from smo_replications import METRICS, metrics_from_summary
+
+
+# Параметры, которые можно изменить в ветви (см. smo_checkpoint.with_changes)
+BRANCH_PARAMS = ("num_operators", "buffer_cap", "op_mean", "interval")
+
+
+def _options(smo, backend: str, trace: TraceLevel) -> dict:
+    # настройки Python-движка, которых нет в снимке: календарь событий
+    # берётся у исходной модели (у NativeSMO — куча, как по умолчанию)
+    if backend != "python":
+        return {}
+    return {"trace": trace, "event_set": getattr(smo, "event_set", "heap")}
+
+
+def fork(smo, backend: Optional[str] = None, trace: TraceLevel = TraceLevel.OFF, **changes):
+    # Независимая копия работающей модели через компактный снимок (календарь,
+    # буфер, операторы, позиции потоков) с изменениями changes. Исходная
+    # модель не меняется; backend по умолчанию — тот же движок, календарь
+    # событий — тот же, что у smo.
+    backend = backend or ("python" if isinstance(smo, SMO) else "native")
+    return loads(with_changes(dumps(smo), **changes), backend, **_options(smo, backend, trace))
+
+
+def _check_changes(changes: dict):
+    unknown = set(changes) - set(BRANCH_PARAMS)
+    if unknown:
+        raise ValueError(f"ветвь: параметры {sorted(unknown)} нельзя менять, только {list(BRANCH_PARAMS)}")
+
+
+def _run_branch(args) -> Dict[str, float]:
+    data, changes, horizon, backend, options, reset = args
+    smo = loads(with_changes(data, **changes), backend, **options)
+    t_end = smo.time + horizon
+    if reset:
+        smo.reset_statistics()
+    events = smo.run_until(t_end)
+    return {**metrics_from_summary(smo.summary()), "events": events}
+
+
+def run_branches(smo, horizon: float, branches: List[dict], backend: Optional[str] = None,
+                 workers: Optional[int] = None, reset: bool = True) -> List[Dict[str, float]]:
+    # Ветви "что если" от текущего состояния smo: каждая — изменения
+    # параметров (BRANCH_PARAMS), прогон на horizon вперёд, показатели METRICS.
+    # Снимок делается один раз и передаётся процессам пула; reset — статистика
+    # только за горизонт ветви. Потоки операторов привязаны к номерам, поэтому
+    # ветви идут на общих случайных числах (с crn — и по заказам).
+    for changes in branches:
+        _check_changes(changes)
+    backend = backend or ("python" if isinstance(smo, SMO) else "native")
+    data = dumps(smo)
+    options = _options(smo, backend, TraceLevel.OFF)
+    tasks = [(data, changes, horizon, backend, options, reset) for changes in branches]
+    workers = min(workers or os.cpu_count() or 1, len(tasks))
+    if workers <= 1:
+        return [_run_branch(t) for t in tasks]
+    with ProcessPoolExecutor(max_workers=workers) as pool:
+        return list(pool.map(_run_branch, tasks))
+
+
+def parse_branch(text: str) -> dict:
+    # "num_operators=7,buffer_cap=6" -> {"num_operators": 7, "buffer_cap": 6}
+    changes = {}
+    for item in text.split(","):
+        key, _, value = item.partition("=")
+        key = key.strip()
+        if key not in BRANCH_PARAMS or not value:
+            raise ValueError(f"--branch: ожидается PARAM=VALUE[,...], PARAM из {list(BRANCH_PARAMS)}")
+        changes[key] = float(value) if key in ("op_mean", "interval") else int(value)
+    return changes
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Ветви 'что если' от общего префикса прогона SMO")
+    parser.add_argument("--t0", type=float, default=5000.0, help="момент ветвления")
+    parser.add_argument("--horizon", type=float, default=1000.0, help="сколько модельного времени считать ветви")
+    parser.add_argument("--branch", action="append", default=[], metavar="PARAM=VALUE[,...]",
+                        help="ветвь с изменёнными параметрами; исходная ветвь считается всегда")
+    parser.add_argument("--workers", type=int, default=None, help="процессов (по умолчанию все ядра)")
+    parser.add_argument("--backend", choices=("python", "native"), default="python")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--restaurants", type=int, default=15)
+    parser.add_argument("--operators", type=int, default=5)
+    parser.add_argument("--interval", type=float, default=4.0)
+    parser.add_argument("--op-mean", type=float, default=2.0)
+    parser.add_argument("--buffer-cap", type=int, default=10)
+    parser.add_argument("--crn", action="store_true", help="времена обслуживания по заказам")
+    args = parser.parse_args()
+
+    try:
+        branches = [{}] + [parse_branch(b) for b in args.branch]
+    except ValueError as e:
+        parser.error(str(e))
+    params = dict(num_restaurants=args.restaurants, num_operators=args.operators,
+                  interval=args.interval, op_mean=args.op_mean, buffer_cap=args.buffer_cap,
+                  seed=args.seed, crn=args.crn)
+    if args.backend == "native":
+        from smo_native import NativeSMO
+        smo = NativeSMO(**params)
+    else:
+        smo = SMO(**params, trace=TraceLevel.OFF)
+
+    start = time.perf_counter()
+    smo.run_until(args.t0)
+    prefix = time.perf_counter() - start
+    start = time.perf_counter()
+    try:
+        results = run_branches(smo, args.horizon, branches, workers=args.workers)
+    except ValueError as e:
+        parser.error(str(e))
+    elapsed = time.perf_counter() - start
+
+    print("\n" + "=" * 70)
+    print(f"ВЕТВИ от t = {smo.time:.2f} на {args.horizon:.0f} вперёд")
+    print("=" * 70)
+    print(f"  {'ветвь':<28}" + "".join(f"{label:>10}" for label in METRICS.values()))
+    for changes, result in zip(branches, results):
+        name = ",".join(f"{k}={v}" for k, v in changes.items()) or "исходная"
+        print(f"  {name:<28}" + "".join(f"{result[key]:>10.4f}" for key in METRICS))
+    print(f"\nОбщий префикс: {prefix:.2f} с; ветви: {elapsed:.2f} с")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,305 @@
+import ctypes
+import os
+import random
+import sys
+from typing import Optional
+
+from smo_food_center import (MASK64, REGENERATIVE_METRICS, BatchMeans, RatioStats, print_statistics,
+                             print_extended_statistics)
+
+
+# Имя библиотеки нативного движка: собирается CMake (CMakeLists.txt в корне)
+# или через FoodDeliverySMO.sln и кладётся рядом с этим модулем.
+if sys.platform == "win32":
+    _LIB_NAME = "smo_native.dll"
+elif sys.platform == "darwin":
+    _LIB_NAME = "libsmo_native.dylib"
+else:
+    _LIB_NAME = "libsmo_native.so"
+
+_lib = None
+
+
+class _RunningStats(ctypes.Structure):
+    # SmoRunningStats из native/smo_capi.h
+    _fields_ = [
+        ("count", ctypes.c_uint64),
+        ("mean", ctypes.c_double),
+        ("m2", ctypes.c_double),
+        ("min", ctypes.c_double),
+        ("max", ctypes.c_double),
+    ]
+
+    @property
+    def variance(self) -> float:
+        return self.m2 / self.count if self.count else 0.0
+
+
+class _RatioStats(ctypes.Structure):
+    # SmoRatioStats из native/smo_capi.h
+    _fields_ = [
+        ("count", ctypes.c_uint64),
+        ("mean_y", ctypes.c_double),
+        ("mean_x", ctypes.c_double),
+        ("cyy", ctypes.c_double),
+        ("cxx", ctypes.c_double),
+        ("cxy", ctypes.c_double),
+    ]
+
+
+def _load_library() -> ctypes.CDLL:
+    global _lib
+    if _lib is not None:
+        return _lib
+
+    path = os.environ.get("SMO_NATIVE_LIB") or os.path.join(os.path.dirname(os.path.abspath(__file__)), _LIB_NAME)
+    if not os.path.exists(path):
+        raise OSError(f"нативный движок не собран: {path} (cmake -S . -B build && cmake --build build)")
+    lib = ctypes.CDLL(path)
+
+    c_engine = ctypes.c_void_p
+    c_i64p = ctypes.POINTER(ctypes.c_int64)
+    c_u64p = ctypes.POINTER(ctypes.c_uint64)
+    c_dblp = ctypes.POINTER(ctypes.c_double)
+
+    lib.smo_last_error.argtypes = []
+    lib.smo_last_error.restype = ctypes.c_char_p
+    lib.smo_create.argtypes = [ctypes.c_int32, ctypes.c_int32, ctypes.c_double,
+                               ctypes.c_double, ctypes.c_int32, ctypes.c_uint64,
+                               ctypes.c_int32, ctypes.c_int32]
+    lib.smo_create.restype = c_engine
+    lib.smo_destroy.argtypes = [c_engine]
+    lib.smo_destroy.restype = None
+    lib.smo_step.argtypes = [c_engine]
+    lib.smo_step.restype = ctypes.c_int32
+    lib.smo_run_until.argtypes = [c_engine, ctypes.c_double]
+    lib.smo_run_until.restype = ctypes.c_int64
+    lib.smo_reset_statistics.argtypes = [c_engine]
+    lib.smo_reset_statistics.restype = ctypes.c_int32
+    lib.smo_stats_start.argtypes = [c_engine]
+    lib.smo_stats_start.restype = ctypes.c_double
+    lib.smo_enable_batch_means.argtypes = [c_engine, ctypes.c_int32]
+    lib.smo_enable_batch_means.restype = ctypes.c_int32
+    lib.smo_batch_means.argtypes = [c_engine, ctypes.c_int32, c_dblp, c_dblp, ctypes.c_int32, c_dblp]
+    lib.smo_batch_means.restype = ctypes.c_int32
+    lib.smo_enable_regenerative.argtypes = [c_engine]
+    lib.smo_enable_regenerative.restype = ctypes.c_int32
+    lib.smo_regenerative.argtypes = [c_engine, ctypes.POINTER(_RatioStats)]
+    lib.smo_regenerative.restype = ctypes.c_int64
+    lib.smo_run_events.argtypes = [c_engine, ctypes.c_double, ctypes.c_uint64]
+    lib.smo_run_events.restype = ctypes.c_int64
+    lib.smo_checkpoint.argtypes = [c_engine, ctypes.c_void_p, ctypes.c_uint64]
+    lib.smo_checkpoint.restype = ctypes.c_uint64
+    lib.smo_restore.argtypes = [ctypes.c_char_p, ctypes.c_uint64]
+    lib.smo_restore.restype = c_engine
+    lib.smo_time.argtypes = [c_engine]
+    lib.smo_time.restype = ctypes.c_double
+    lib.smo_buffer_area.argtypes = [c_engine]
+    lib.smo_buffer_area.restype = ctypes.c_double
+    lib.smo_buffer_length.argtypes = [c_engine]
+    lib.smo_buffer_length.restype = ctypes.c_int32
+    lib.smo_totals.argtypes = [c_engine, c_u64p]
+    lib.smo_totals.restype = ctypes.c_int32
+    c_statsp = ctypes.POINTER(_RunningStats)
+    lib.smo_restaurant_stats.argtypes = [c_engine, c_i64p, c_u64p, c_statsp, c_statsp]
+    lib.smo_restaurant_stats.restype = ctypes.c_int32
+    lib.smo_operator_busy_time.argtypes = [c_engine, c_dblp]
+    lib.smo_operator_busy_time.restype = ctypes.c_int32
+
+    _lib = lib
+    return lib
+
+
+def _last_error(lib: ctypes.CDLL) -> str:
+    return lib.smo_last_error().decode("utf-8", "replace")
+
+
+def _check(lib: ctypes.CDLL, result: int, bad: int = -1) -> int:
+    # коды ошибок C-интерфейса (smo_capi.h) -> RuntimeError с текстом движка
+    if result <= bad:
+        raise RuntimeError(f"нативный движок: {_last_error(lib)}")
+    return result
+
+
+INT32_MIN = -(1 << 31)
+INT32_MAX = (1 << 31) - 1
+
+
+def _check_int32(**values: int):
+    # ctypes.c_int32 молча обрезает большие числа до младших 32 бит —
+    # такие параметры отклоняются до вызова движка
+    for name, value in values.items():
+        if not INT32_MIN <= value <= INT32_MAX:
+            raise ValueError(f"{name}={value} не помещается в 32-битное целое нативного движка")
+
+
+def native_available() -> bool:
+    try:
+        _load_library()
+    except OSError:
+        return False
+    return True
+
+
+class NativeSMO:
+    # Нативный движок с тем же конструктором, что у SMO: при одинаковых
+    # параметрах и seed даёт ту же последовательность событий и ту же summary().
+    # Журнала событий и пошагового вывода состояния нет — только счёт.
+
+    def __init__(
+        self,
+        num_restaurants: int = 15,
+        num_operators: int = 50,
+        interval: float = 0.2,
+        op_mean: float = 2.0,
+        buffer_cap: int = 100,
+        seed: Optional[int] = 1,
+        crn: bool = False,
+        antithetic: bool = False,
+        batch_means: bool = False,
+        regenerative: bool = False
+    ):
+        _check_int32(num_restaurants=num_restaurants, num_operators=num_operators, buffer_cap=buffer_cap)
+        if seed is None:
+            seed = random.getrandbits(64)
+        self.seed = seed & MASK64   # как SMO.seed
+        self._lib = _load_library()
+        self.num_restaurants = num_restaurants
+        self.num_operators = num_operators
+        self.crn = crn
+        self.antithetic = antithetic
+        self._engine = self._lib.smo_create(num_restaurants, num_operators, interval,
+                                            op_mean, buffer_cap, self.seed, int(crn), int(antithetic))
+        if not self._engine:
+            raise ValueError(f"не удалось создать нативный движок: {_last_error(self._lib)}")
+        self._max_batches = BatchMeans().max_batches
+        if batch_means:
+            _check(self._lib, self._lib.smo_enable_batch_means(self._engine, self._max_batches))
+        if regenerative:
+            _check(self._lib, self._lib.smo_enable_regenerative(self._engine))
+
+    def __del__(self):
+        engine = getattr(self, "_engine", None)
+        if engine:
+            self._lib.smo_destroy(engine)
+            self._engine = None
+
+    @property
+    def time(self) -> float:
+        return self._lib.smo_time(self._engine)
+
+    def step(self) -> bool:
+        return bool(_check(self._lib, self._lib.smo_step(self._engine)))
+
+    def run_until(self, t_max: float, max_events: Optional[int] = None) -> int:
+        # эквивалент `while smo.time < t_max and smo.step(): pass`
+        if max_events is None:
+            return _check(self._lib, self._lib.smo_run_until(self._engine, t_max))
+        if not 0 <= max_events <= MASK64:
+            raise ValueError(f"max_events={max_events} вне диапазона 0..2^64-1")
+        return _check(self._lib, self._lib.smo_run_events(self._engine, t_max, max_events))
+
+    def checkpoint(self) -> bytes:
+        # снимок состояния в формате smo_checkpoint (общем с SMO)
+        size = _check(self._lib, self._lib.smo_checkpoint(self._engine, None, 0), 0)
+        buf = ctypes.create_string_buffer(size)
+        self._lib.smo_checkpoint(self._engine, buf, size)
+        return buf.raw
+
+    @classmethod
+    def from_checkpoint(cls, data: bytes) -> "NativeSMO":
+        from smo_checkpoint import bad_checkpoint, read_header
+        header = read_header(data)
+        self = cls.__new__(cls)
+        self._lib = _load_library()
+        self._engine = self._lib.smo_restore(data, len(data))
+        if not self._engine:
+            raise bad_checkpoint(_last_error(self._lib))
+        self.seed = header["seed"]
+        self.num_restaurants = header["num_restaurants"]
+        self.num_operators = header["num_operators"]
+        self.crn = header["crn"]
+        self.antithetic = header["antithetic"]
+        self._max_batches = BatchMeans().max_batches
+        return self
+
+    def reset_statistics(self):
+        # как SMO.reset_statistics
+        _check(self._lib, self._lib.smo_reset_statistics(self._engine))
+
+    def batch_means(self) -> dict:
+        # как SMO.batch_means: копии накопителей движка
+        result = {}
+        cap = self._max_batches
+        for which, name in enumerate(("wait", "system", "buffer")):
+            sums = (ctypes.c_double * cap)()
+            weights = (ctypes.c_double * cap)()
+            state = (ctypes.c_double * 3)()
+            n = _check(self._lib, self._lib.smo_batch_means(self._engine, which, sums, weights, cap, state), -2)
+            if n < 0:
+                raise ValueError("пакетные средние не включены (NativeSMO(batch_means=True))")
+            bm = BatchMeans(cap, state[0])
+            bm.sums, bm.weights = list(sums[:n]), list(weights[:n])
+            bm._sum, bm._weight = state[1], state[2]
+            result[name] = bm
+        return result
+
+    def regenerative(self) -> dict:
+        # как SMO.regenerative: копии накопителей движка
+        out = (_RatioStats * len(REGENERATIVE_METRICS))()
+        if _check(self._lib, self._lib.smo_regenerative(self._engine, out), -2) < 0:
+            raise ValueError("циклы регенерации не включены (NativeSMO(regenerative=True))")
+        result = {}
+        for key, src in zip(REGENERATIVE_METRICS, out):
+            rs = RatioStats()
+            for name, _ in _RatioStats._fields_:
+                setattr(rs, name, getattr(src, name))
+            result[key] = rs
+        return result
+
+    def summary(self) -> dict:
+        n = self.num_restaurants
+        totals = (ctypes.c_uint64 * 3)()
+        generated = (ctypes.c_int64 * n)()
+        rejected = (ctypes.c_uint64 * n)()
+        wait = (_RunningStats * n)()
+        system = (_RunningStats * n)()
+        busy_time = (ctypes.c_double * self.num_operators)()
+
+        _check(self._lib, self._lib.smo_totals(self._engine, totals))
+        _check(self._lib, self._lib.smo_restaurant_stats(self._engine, generated, rejected, wait, system))
+        _check(self._lib, self._lib.smo_operator_busy_time(self._engine, busy_time))
+
+        # те же правила, что в SMO.summary
+        def lo(st: _RunningStats) -> float:
+            return st.min if st.count else 0.0
+
+        def hi(st: _RunningStats) -> float:
+            return st.max if st.count else 0.0
+
+        return {
+            "time": self.time,
+            "stats_start": self._lib.smo_stats_start(self._engine),
+            "total_generated": totals[0],
+            "total_processed": totals[1],
+            "total_rejected": totals[2],
+            "generated": list(generated),
+            "rejected": list(rejected),
+            "processed": [w.count for w in wait],
+            "wait_mean": [w.mean for w in wait],
+            "wait_var": [w.variance for w in wait],
+            "wait_min": [lo(w) for w in wait],
+            "wait_max": [hi(w) for w in wait],
+            "system_mean": [t.mean for t in system],
+            "system_var": [t.variance for t in system],
+            "system_min": [lo(t) for t in system],
+            "system_max": [hi(t) for t in system],
+            "busy_time": list(busy_time),
+            "buffer_area": self._lib.smo_buffer_area(self._engine),
+        }
+
+    def print_statistics(self):
+        print_statistics(self.summary())
+
+    def print_extended_statistics(self):
+        print_extended_statistics(self.summary())
@@ -0,0 +1,68 @@
+import argparse
+import math
+import time
+from typing import Dict
+
+from smo_food_center import RatioStats, SMO, TraceLevel
+from smo_replications import METRICS, Estimate, print_estimates, t_quantile
+
+
+def ratio_estimate(rs: RatioStats, confidence: float = 0.95) -> Estimate:
+    # Отношение r = E[Y] / E[X] по n независимым циклам: дисперсия оценки
+    # из остатков Y_i - r X_i (s^2 = (Cyy - 2r Cxy + r^2 Cxx) / (n - 1)),
+    # полуширина t * s / (mean_x * sqrt(n)). n в Estimate — число циклов.
+    n = rs.count
+    if n == 0 or rs.mean_x == 0.0:
+        return Estimate(0.0, math.inf, n)
+    r = rs.mean_y / rs.mean_x
+    if n < 2:
+        return Estimate(r, math.inf, n)
+    s2 = max(rs.cyy - 2 * r * rs.cxy + r * r * rs.cxx, 0.0) / (n - 1)
+    half_width = t_quantile(0.5 + confidence / 2, n - 1) * math.sqrt(s2 / n) / rs.mean_x
+    return Estimate(r, half_width, n)
+
+
+def analyze(smo, confidence: float = 0.95) -> Dict[str, Estimate]:
+    # smo — SMO или NativeSMO, созданные с regenerative=True
+    return {key: ratio_estimate(rs, confidence) for key, rs in smo.regenerative().items()}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Один прогон SMO с оценкой по циклам регенерации")
+    parser.add_argument("--t-max", type=float, default=100000.0)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--backend", choices=("python", "native"), default="python")
+    parser.add_argument("--confidence", type=float, default=0.95)
+    parser.add_argument("--restaurants", type=int, default=15)
+    parser.add_argument("--operators", type=int, default=5)
+    parser.add_argument("--interval", type=float, default=10.0)
+    parser.add_argument("--op-mean", type=float, default=2.0)
+    parser.add_argument("--buffer-cap", type=int, default=3)
+    args = parser.parse_args()
+
+    params = dict(num_restaurants=args.restaurants, num_operators=args.operators,
+                  interval=args.interval, op_mean=args.op_mean, buffer_cap=args.buffer_cap,
+                  seed=args.seed, regenerative=True)
+    if args.backend == "native":
+        from smo_native import NativeSMO
+        smo = NativeSMO(**params)
+    else:
+        smo = SMO(**params, trace=TraceLevel.OFF)
+
+    start = time.perf_counter()
+    smo.run_until(args.t_max)
+    elapsed = time.perf_counter() - start
+    estimates = analyze(smo, args.confidence)
+    print_estimates(estimates, args.confidence, title="ЦИКЛЫ РЕГЕНЕРАЦИИ: отношения")
+
+    cycles = smo.regenerative()["buffer_mean"]
+    if cycles.count < 30:
+        print(f"\n  ! законченных циклов {cycles.count}: система редко пустеет, интервалы ненадёжны "
+              f"(см. smo_batch_means.py)")
+    else:
+        print(f"\nЦиклов: {cycles.count}, средняя длина цикла {cycles.mean_x:.2f}")
+    print(f"Счёт: {elapsed:.2f} с")
+
+
+if __name__ == "__main__":
+    main()
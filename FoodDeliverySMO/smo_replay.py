@@ -0,0 +1,232 @@
+import argparse
+import csv
+import math
+import queue
+import struct
+import threading
+import time
+from itertools import chain
+from typing import Iterator, List, Optional, Tuple
+
+from smo_food_center import SMO, Event, EventType, TraceLevel
+
+
+# Журнал поступлений для SMO(arrivals=ArrivalLog(...)): записи (время,
+# ресторан, время обслуживания или None) по неубыванию времени. Форматы:
+#   CSV с заголовком: столбцы time, restaurant_id и необязательный
+#     service_time (пустое значение — разыграть время потоком оператора);
+#   двоичный: BIN_HEAD (BIN_MAGIC, версия), затем записи RECORD — time d,
+#     restaurant_id i, service_time d (NaN — не задано). Читается в разы
+#     быстрее CSV; `smo_replay.py convert` переводит CSV в него.
+# Время в журнале — в единицах модели; origin вычитается из всех времён
+# (по умолчанию время первой записи, так что прогон начинается с нуля).
+BIN_MAGIC = b"SMOARRV\0"
+BIN_VERSION = 1
+BIN_HEAD = struct.Struct("<8sI")
+RECORD = struct.Struct("<did")
+CHUNK = 16384          # записей в порции фонового чтения
+PREFETCH = 4           # порций в очереди: память не больше PREFETCH * CHUNK записей
+
+Record = Tuple[float, int, Optional[float]]
+
+
+class ReplayArrival(Event):
+    # Поступление из журнала: событие несёт время обслуживания своего заказа
+    # (None — разыграть потоком оператора)
+    __slots__ = ("service_time",)
+
+    def __init__(self, time: float, restaurant_id: int, order_id: int, service_time: Optional[float]):
+        super().__init__(time, EventType.ORDER_GENERATED, restaurant_id=restaurant_id, order_id=order_id)
+        self.service_time = service_time
+
+
+def _csv_chunks(path: str, chunk: int) -> Iterator[List[Record]]:
+    with open(path, newline="") as f:
+        reader = csv.reader(f)
+        header = [h.strip() for h in next(reader, [])]
+        try:
+            t_col, r_col = header.index("time"), header.index("restaurant_id")
+        except ValueError:
+            raise ValueError(f"{path}: нужны столбцы time и restaurant_id") from None
+        s_col = header.index("service_time") if "service_time" in header else None
+        records: List[Record] = []
+        for row in reader:
+            if not row:
+                continue
+            try:
+                s = row[s_col].strip() if s_col is not None else ""
+                records.append((float(row[t_col]), int(row[r_col]), float(s) if s else None))
+            except (ValueError, IndexError):
+                raise ValueError(f"{path}:{reader.line_num}: неверная запись {row!r}") from None
+            if len(records) == chunk:
+                yield records
+                records = []
+        if records:
+            yield records
+
+
+def _binary_chunks(path: str, chunk: int) -> Iterator[List[Record]]:
+    with open(path, "rb") as f:
+        head = f.read(BIN_HEAD.size)
+        if len(head) < BIN_HEAD.size or BIN_HEAD.unpack(head)[0] != BIN_MAGIC:
+            raise ValueError(f"{path}: не журнал поступлений")
+        if BIN_HEAD.unpack(head)[1] != BIN_VERSION:
+            raise ValueError(f"{path}: неподдерживаемая версия журнала поступлений")
+        while True:
+            data = f.read(RECORD.size * chunk)
+            if not data:
+                return
+            if len(data) % RECORD.size:
+                raise ValueError(f"{path}: журнал обрезан")
+            yield [(t, r, None if s != s else s) for t, r, s in RECORD.iter_unpack(data)]
+
+
+def read_chunks(path: str, chunk: int = CHUNK) -> Iterator[List[Record]]:
+    # Порции записей журнала; формат определяется по первым байтам файла
+    with open(path, "rb") as f:
+        binary = f.read(len(BIN_MAGIC)) == BIN_MAGIC
+    return (_binary_chunks if binary else _csv_chunks)(path, chunk)
+
+
+class ArrivalLog:
+    # Поступления из журнала с упреждающим чтением: фоновый поток разбирает
+    # файл порциями по chunk записей и кладёт их в очередь на prefetch
+    # порций, так что память ограничена при любой длине журнала, а шаг
+    # модели не ждёт диска. Проверяет, что время не убывает и номер ресторана
+    # меньше числа ресторанов модели. Одна лента — одна модель.
+    def __init__(self, path: str, origin: Optional[float] = None, chunk: int = CHUNK,
+                 prefetch: int = PREFETCH):
+        if chunk < 1 or prefetch < 1:
+            raise ValueError("chunk и prefetch должны быть >= 1")
+        self.path = path
+        self.origin = origin
+        self.records = 0
+        self.pending: Optional[ReplayArrival] = None   # последнее выданное — оно и ждёт в календаре
+        self._last_time = -math.inf
+        self._sources = None
+        self._queue: "queue.Queue" = queue.Queue(maxsize=prefetch)
+        self._stop = threading.Event()
+        self._thread = threading.Thread(target=self._read, args=(chunk,), name="smo-arrivals", daemon=True)
+        self._thread.start()
+        self._records = chain.from_iterable(iter(self._take, None))
+
+    def _read(self, chunk: int):
+        try:
+            for records in read_chunks(self.path, chunk):
+                if not self._put(records):
+                    return
+            self._put(None)
+        except BaseException as e:
+            self._put(e)
+
+    def _put(self, item) -> bool:
+        while not self._stop.is_set():
+            try:
+                self._queue.put(item, timeout=0.1)
+                return True
+            except queue.Full:
+                pass
+        return False
+
+    def _take(self) -> Optional[List[Record]]:
+        item = self._queue.get()
+        if isinstance(item, BaseException):
+            raise ValueError(f"журнал поступлений: {item}") from item
+        return item
+
+    def bind(self, sources):
+        # источники ресторанов модели (SMO вызывает при создании)
+        if self._sources is not None:
+            raise ValueError("журнал поступлений уже используется другой моделью")
+        self._sources = sources
+
+    def next_event(self) -> Optional[ReplayArrival]:
+        # Следующее поступление или None в конце журнала
+        record = next(self._records, None)
+        if record is None:
+            self.pending = None
+            return None
+        t, rid, service = record
+        if self.origin is None:
+            self.origin = t
+        t -= self.origin
+        if t < self._last_time:
+            raise ValueError(f"журнал поступлений: время убывает в записи {self.records + 1}")
+        if t < 0:   # только первая запись: дальше время не убывает
+            raise ValueError(f"журнал поступлений: время первой записи {t + self.origin} "
+                             f"раньше начала отсчёта origin = {self.origin}")
+        if not 0 <= rid < len(self._sources):
+            raise ValueError(f"журнал поступлений: ресторан {rid} в записи {self.records + 1}, "
+                             f"в модели {len(self._sources)}")
+        self._last_time = t
+        self.records += 1
+        src = self._sources[rid]
+        ev = ReplayArrival(t, rid, src.generated, service)
+        src.generated += 1
+        self.pending = ev
+        return ev
+
+    def close(self):
+        self._stop.set()
+        self._thread.join()
+
+    def __enter__(self) -> "ArrivalLog":
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+def convert(src: str, dst: str) -> int:
+    # CSV -> двоичный журнал; возвращает число записей
+    n = 0
+    with open(dst, "wb") as out:
+        out.write(BIN_HEAD.pack(BIN_MAGIC, BIN_VERSION))
+        for records in read_chunks(src):
+            out.write(b"".join(RECORD.pack(t, r, math.nan if s is None else s) for t, r, s in records))
+            n += len(records)
+    return n
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Воспроизведение журнала поступлений через SMO")
+    sub = parser.add_subparsers(dest="command", required=True)
+    run = sub.add_parser("run", help="прогон SMO на поступлениях из журнала (CSV или двоичного)")
+    run.add_argument("path")
+    run.add_argument("--restaurants", type=int, default=15)
+    run.add_argument("--operators", type=int, default=5)
+    run.add_argument("--op-mean", type=float, default=2.0,
+                     help="среднее время обслуживания для записей без service_time")
+    run.add_argument("--buffer-cap", type=int, default=3)
+    run.add_argument("--seed", type=int, default=1)
+    run.add_argument("--origin", type=float, default=None,
+                     help="начало отсчёта времени (по умолчанию время первой записи)")
+    run.add_argument("--t-max", type=float, default=None, help="остановиться в этот момент")
+    conv = sub.add_parser("convert", help="CSV -> двоичный журнал поступлений")
+    conv.add_argument("src")
+    conv.add_argument("dst")
+    args = parser.parse_args()
+
+    if args.command == "convert":
+        start = time.perf_counter()
+        n = convert(args.src, args.dst)
+        print(f"Записей: {n}, {time.perf_counter() - start:.2f} с")
+        return
+
+    start = time.perf_counter()
+    with ArrivalLog(args.path, origin=args.origin) as arrivals:
+        smo = SMO(num_restaurants=args.restaurants, num_operators=args.operators, op_mean=args.op_mean,
+                  buffer_cap=args.buffer_cap, seed=args.seed, trace=TraceLevel.OFF, arrivals=arrivals)
+        if args.t_max is None:
+            while smo.step():
+                pass
+        else:
+            smo.run_until(args.t_max)
+    elapsed = time.perf_counter() - start
+    smo.print_extended_statistics()
+    print(f"\nПоступлений из журнала: {arrivals.records}, модельное время {smo.time:.2f}, "
+          f"счёт {elapsed:.2f} с ({smo.time / elapsed:.0f} единиц модельного времени в секунду)")
+
+
+if __name__ == "__main__":
+    main()
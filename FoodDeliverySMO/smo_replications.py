@@ -0,0 +1,364 @@
+import argparse
+import math
+import os
+import time
+from concurrent.futures import ProcessPoolExecutor
+from dataclasses import dataclass
+from statistics import NormalDist
+from typing import Dict, List, Optional
+
+from smo_checkpoint import dumps, loads, with_seed
+from smo_food_center import SMO, TraceLevel, split_key
+
+
+# Показатели одного прогона, которые усредняются по репликациям
+METRICS = {
+    "p_reject": "Pотк",
+    "wait_mean": "E[Tож]",
+    "system_mean": "E[Tпр]",
+    "utilization": "Kисп",
+    "buffer_mean": "Lбуф",
+}
+
+
+def metrics_from_summary(s: dict) -> Dict[str, float]:
+    # Сводные показатели по всей системе из SMO.summary()/NativeSMO.summary()
+    T = s["time"] - s.get("stats_start", 0.0)
+    T = T if T > 0 else 1.0
+    processed = sum(s["processed"])
+
+    def pooled_mean(means: List[float]) -> float:
+        if not processed:
+            return 0.0
+        return sum(n * m for n, m in zip(s["processed"], means)) / processed
+
+    busy = s["busy_time"]
+    return {
+        "p_reject": s["total_rejected"] / s["total_generated"] if s["total_generated"] else 0.0,
+        "wait_mean": pooled_mean(s["wait_mean"]),
+        "system_mean": pooled_mean(s["system_mean"]),
+        "utilization": (sum(busy) / len(busy)) / T if busy else 0.0,
+        "buffer_mean": s["buffer_area"] / T,
+    }
+
+
+def replication_seed(base_seed: int, index: int) -> int:
+    # Ключ репликации index выводится из базового через SplitMix64:
+    # соседние base_seed не дают пересекающихся наборов потоков
+    return split_key(base_seed, index)
+
+
+def make_model(params: dict, seed: int, backend: str = "python"):
+    if backend == "native":
+        from smo_native import NativeSMO
+        return NativeSMO(**params, seed=seed)
+    return SMO(**params, seed=seed, trace=TraceLevel.OFF)
+
+
+def run_replication(params: dict, t_max: float, seed: int, backend: str = "python",
+                    warmup: bool = False) -> Dict[str, float]:
+    # Показатели METRICS и число обработанных событий "events"; warmup:
+    # статистика с момента конца разгона по MSER-5 (smo_warmup), сам момент
+    # возвращается в поле "warmup"
+    if warmup:
+        from smo_warmup import run_with_warmup
+        smo, t_w, events = run_with_warmup(lambda: make_model(params, seed, backend), t_max)
+        return {**metrics_from_summary(smo.summary()), "events": events, "warmup": t_w}
+    smo = make_model(params, seed, backend)
+    events = smo.run_until(t_max)
+    return {**metrics_from_summary(smo.summary()), "events": events}
+
+
+def _run_indexed(args) -> Dict[str, float]:
+    return run_replication(*args)
+
+
+def warm_snapshot(params: dict, t_warmup: float, seed: int, backend: str = "python") -> bytes:
+    # Общий разгон: один прогон до t_warmup, сброс статистики, снимок
+    smo = make_model(params, seed, backend)
+    smo.run_until(t_warmup)
+    smo.reset_statistics()
+    return dumps(smo)
+
+
+def run_from_snapshot(data: bytes, t_max: float, seed: int, backend: str = "python",
+                      antithetic: bool = False) -> Dict[str, float]:
+    # Продолжение прогретого состояния до t_max на потоках, заново
+    # выведенных из seed; "events" — события после разгона
+    smo = loads(with_seed(data, seed, antithetic), backend, trace=TraceLevel.OFF)
+    events = smo.run_until(t_max)
+    return {**metrics_from_summary(smo.summary()), "events": events}
+
+
+def _run_forked(args) -> Dict[str, float]:
+    return run_from_snapshot(*args)
+
+
+def t_quantile(p: float, df: int) -> float:
+    # Квантиль распределения Стьюдента: точные формулы для df = 1, 2,
+    # далее разложение Корниша–Фишера от нормального квантиля (относительная
+    # погрешность около 0.1% при df = 3 и быстро убывает с ростом df)
+    if df == 1:
+        return math.tan(math.pi * (p - 0.5))
+    if df == 2:
+        return (2 * p - 1) / math.sqrt(2 * p * (1 - p))
+    z = NormalDist().inv_cdf(p)
+    g1 = (z ** 3 + z) / 4
+    g2 = (5 * z ** 5 + 16 * z ** 3 + 3 * z) / 96
+    g3 = (3 * z ** 7 + 19 * z ** 5 + 17 * z ** 3 - 15 * z) / 384
+    g4 = (79 * z ** 9 + 776 * z ** 7 + 1482 * z ** 5 - 1920 * z ** 3 - 945 * z) / 92160
+    return z + g1 / df + g2 / df ** 2 + g3 / df ** 3 + g4 / df ** 4
+
+
+@dataclass
+class Estimate:
+    mean: float
+    half_width: float   # полуширина доверительного интервала
+    n: int
+
+    @property
+    def relative_half_width(self) -> float:
+        return self.half_width / abs(self.mean) if self.mean else math.inf
+
+
+def estimate(values: List[float], confidence: float = 0.95) -> Estimate:
+    n = len(values)
+    m = sum(values) / n
+    if n < 2:
+        return Estimate(m, math.inf, n)
+    s2 = sum((v - m) ** 2 for v in values) / (n - 1)
+    return Estimate(m, t_quantile(0.5 + confidence / 2, n - 1) * math.sqrt(s2 / n), n)
+
+
+def merge_replications(runs: List[Dict[str, float]], confidence: float = 0.95) -> Dict[str, Estimate]:
+    return {key: estimate([r[key] for r in runs], confidence) for key in METRICS}
+
+
+def _map_tasks(tasks: list, workers: Optional[int], run=_run_indexed) -> List[Dict[str, float]]:
+    workers = workers or os.cpu_count() or 1
+    if workers == 1:
+        return [run(t) for t in tasks]
+    chunksize = max(1, len(tasks) // (4 * workers))
+    with ProcessPoolExecutor(max_workers=workers) as pool:
+        return list(pool.map(run, tasks, chunksize=chunksize))
+
+
+def run_replications(
+    params: dict,
+    t_max: float,
+    replications: int,
+    base_seed: int = 1,
+    backend: str = "python",
+    workers: Optional[int] = None,
+    first_index: int = 0,
+    antithetic: bool = False,
+    warmup: bool = False,
+    shared_warmup: Optional[float] = None,
+    snapshot: Optional[bytes] = None
+) -> List[Dict[str, float]]:
+    # R независимых прогонов на пуле процессов (по умолчанию — все ядра).
+    # antithetic: R антитетичных пар — прогоны с одним seed на u и на 1 - u;
+    # результатом репликации считается среднее по паре.
+    # shared_warmup: разгон до этого момента считается один раз (seed =
+    # base_seed), и все прогоны продолжают его снимок на своих потоках со
+    # статистикой с момента shared_warmup. Прогоны независимы при условии
+    # общего начального состояния. snapshot — уже посчитанный снимок
+    # warm_snapshot(params, shared_warmup, base_seed, backend).
+    seeds = [replication_seed(base_seed, first_index + r) for r in range(replications)]
+    if shared_warmup is not None:
+        if warmup:
+            raise ValueError("warmup и shared_warmup несовместимы")
+        if not 0 < shared_warmup < t_max:
+            raise ValueError("shared_warmup должен быть внутри (0, t_max)")
+        data = snapshot if snapshot is not None else warm_snapshot(params, shared_warmup, base_seed, backend)
+        tasks = [(data, t_max, seed, backend, anti) for seed in seeds
+                 for anti in ((False, True) if antithetic else (False,))]
+        runs = _map_tasks(tasks, workers, _run_forked)
+        if not antithetic:
+            return runs
+    elif not antithetic:
+        return _map_tasks([(params, t_max, seed, backend, warmup) for seed in seeds], workers)
+    else:
+        tasks = [({**params, "antithetic": anti}, t_max, seed, backend, warmup)
+                 for seed in seeds for anti in (False, True)]
+        runs = _map_tasks(tasks, workers)
+    return [{**{key: (u[key] + v[key]) / 2 for key in u}, "events": u["events"] + v["events"]}
+            for u, v in zip(runs[0::2], runs[1::2])]
+
+
+def compare_configs(
+    params_a: dict,
+    params_b: dict,
+    t_max: float,
+    replications: int,
+    base_seed: int = 1,
+    backend: str = "python",
+    workers: Optional[int] = None,
+    crn: bool = True,
+    antithetic: bool = False,
+    confidence: float = 0.95,
+    warmup: bool = False,
+    shared_warmup: Optional[float] = None
+) -> Dict[str, Estimate]:
+    # Разность показателей B - A по парам прогонов с одинаковым seed.
+    # С crn заказ получает одно и то же время обслуживания в обеих
+    # конфигурациях, и шум генератора в разности почти сокращается.
+    runs_a = run_replications({**params_a, "crn": crn}, t_max, replications, base_seed,
+                              backend, workers, antithetic=antithetic, warmup=warmup,
+                              shared_warmup=shared_warmup)
+    runs_b = run_replications({**params_b, "crn": crn}, t_max, replications, base_seed,
+                              backend, workers, antithetic=antithetic, warmup=warmup,
+                              shared_warmup=shared_warmup)
+    return {key: estimate([b[key] - a[key] for a, b in zip(runs_a, runs_b)], confidence)
+            for key in METRICS}
+
+
+# Показатели, по точности которых по умолчанию останавливается run_to_precision
+PRECISION_METRICS = ("p_reject", "wait_mean")
+
+
+@dataclass
+class SequentialResult:
+    runs: List[Dict[str, float]]
+    estimates: Dict[str, Estimate]
+    converged: bool          # достигнута ли точность до max_replications
+    events: int              # событий во всех прогонах
+    wall_time: float         # секунд счёта
+
+
+def precision_reached(estimates: Dict[str, Estimate], precision: float, keys=PRECISION_METRICS) -> bool:
+    # Полуширина не больше precision * |среднее|; нулевой показатель с
+    # нулевым разбросом (например, ни одного отказа) считается точным
+    return all(estimates[k].n >= 2 and estimates[k].half_width <= precision * abs(estimates[k].mean)
+               for k in keys)
+
+
+def run_to_precision(
+    params: dict,
+    t_max: float,
+    precision: float,
+    keys=PRECISION_METRICS,
+    initial: int = 8,
+    max_replications: int = 4096,
+    base_seed: int = 1,
+    backend: str = "python",
+    workers: Optional[int] = None,
+    confidence: float = 0.95,
+    antithetic: bool = False,
+    warmup: bool = False,
+    shared_warmup: Optional[float] = None
+) -> SequentialResult:
+    # Последовательная процедура: прогоны добавляются партиями, и число
+    # репликаций удваивается (initial, 2*initial, 4*initial, ...), пока
+    # относительная полуширина интервалов keys не станет <= precision.
+    # Проверка — только в этих геометрических точках, поэтому её стоимость
+    # ничтожна, а перерасход прогонов — не больше чем вдвое. Общий разгон
+    # считается один раз на все партии.
+    start = time.perf_counter()
+    snapshot = None
+    if shared_warmup is not None and 0 < shared_warmup < t_max and not warmup:
+        snapshot = warm_snapshot(params, shared_warmup, base_seed, backend)
+    runs: List[Dict[str, float]] = []
+    target = initial
+    while True:
+        runs += run_replications(params, t_max, target - len(runs), base_seed, backend, workers,
+                                 first_index=len(runs), antithetic=antithetic, warmup=warmup,
+                                 shared_warmup=shared_warmup, snapshot=snapshot)
+        estimates = merge_replications(runs, confidence)
+        converged = precision_reached(estimates, precision, keys)
+        if converged or len(runs) >= max_replications:
+            break
+        target = min(2 * len(runs), max_replications)
+    return SequentialResult(runs, estimates, converged, int(sum(r["events"] for r in runs)),
+                            time.perf_counter() - start)
+
+
+def print_estimates(estimates: Dict[str, Estimate], confidence: float = 0.95,
+                    title: str = "НЕЗАВИСИМЫЕ ПРОГОНЫ: средние"):
+    print("\n" + "=" * 70)
+    print(f"{title} и {confidence * 100:.0f}% доверительные интервалы")
+    print("=" * 70)
+    for key, label in METRICS.items():
+        e = estimates[key]
+        print(f"  {label:<8} = {e.mean:.4f} ± {e.half_width:.4f}  (n={e.n})")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Независимые прогоны SMO с доверительными интервалами")
+    parser.add_argument("-R", "--replications", type=int, default=10)
+    parser.add_argument("--t-max", type=float, default=10000.0)
+    parser.add_argument("--seed", type=int, default=1, help="базовый seed")
+    parser.add_argument("--workers", type=int, default=None, help="процессов (по умолчанию все ядра)")
+    parser.add_argument("--backend", choices=("python", "native"), default="python")
+    parser.add_argument("--confidence", type=float, default=0.95)
+    parser.add_argument("--restaurants", type=int, default=15)
+    parser.add_argument("--operators", type=int, default=5)
+    parser.add_argument("--interval", type=float, default=10.0)
+    parser.add_argument("--op-mean", type=float, default=2.0)
+    parser.add_argument("--buffer-cap", type=int, default=3)
+    parser.add_argument("--crn", action="store_true",
+                        help="общие случайные числа: время обслуживания привязано к заказу")
+    parser.add_argument("--antithetic", action="store_true",
+                        help="R антитетичных пар прогонов вместо R независимых")
+    parser.add_argument("--warmup", action="store_true",
+                        help="отсекать разгон (MSER-5) в каждом прогоне")
+    parser.add_argument("--shared-warmup", type=float, default=None, metavar="T",
+                        help="один общий разгон до T, затем все прогоны продолжают его "
+                             "на своих потоках со статистикой с момента T")
+    parser.add_argument("--precision", type=float, default=None,
+                        help="добавлять прогоны (R, 2R, 4R, ...), пока относительная полуширина "
+                             "интервалов Pотк и E[Tож] не станет не больше заданной, например 0.05")
+    parser.add_argument("--max-replications", type=int, default=4096)
+    parser.add_argument("--compare", action="append", metavar="PARAM=VALUE",
+                        help="сравнить с конфигурацией, где PARAM=VALUE (разность B - A по парам, "
+                             "по умолчанию с --crn)")
+    args = parser.parse_args()
+    if args.warmup and args.shared_warmup is not None:
+        parser.error("--warmup и --shared-warmup несовместимы")
+    if args.shared_warmup is not None and not 0 < args.shared_warmup < args.t_max:
+        parser.error("--shared-warmup должен быть между 0 и --t-max")
+
+    params = dict(num_restaurants=args.restaurants, num_operators=args.operators,
+                  interval=args.interval, op_mean=args.op_mean, buffer_cap=args.buffer_cap)
+    start = time.perf_counter()
+    if args.compare:
+        other = dict(params)
+        for item in args.compare:
+            key, _, value = item.partition("=")
+            if key not in params or not value:
+                parser.error(f"--compare: ожидается PARAM=VALUE, PARAM из {sorted(params)}")
+            other[key] = type(params[key])(value)
+        diffs = compare_configs(params, other, args.t_max, args.replications, args.seed,
+                                args.backend, args.workers, crn=True, antithetic=args.antithetic,
+                                confidence=args.confidence, warmup=args.warmup,
+                                shared_warmup=args.shared_warmup)
+        elapsed = time.perf_counter() - start
+        changed = ", ".join(args.compare)
+        print_estimates(diffs, args.confidence, title=f"РАЗНОСТЬ ({changed}) - (исходная)")
+    elif args.precision is not None:
+        result = run_to_precision({**params, "crn": args.crn}, args.t_max, args.precision,
+                                  initial=args.replications, max_replications=args.max_replications,
+                                  base_seed=args.seed, backend=args.backend, workers=args.workers,
+                                  confidence=args.confidence, antithetic=args.antithetic,
+                                  warmup=args.warmup, shared_warmup=args.shared_warmup)
+        print_estimates(result.estimates, args.confidence)
+        state = "достигнута" if result.converged else "НЕ достигнута (предел --max-replications)"
+        print(f"\nТочность {args.precision:.3f}: {state}; "
+              f"прогонов {len(result.runs)}, событий {result.events}, "
+              f"модельного времени {len(result.runs) * args.t_max:.0f}, счёт {result.wall_time:.2f} с")
+        return
+    else:
+        runs = run_replications({**params, "crn": args.crn}, args.t_max, args.replications,
+                                args.seed, args.backend, args.workers, antithetic=args.antithetic,
+                                warmup=args.warmup, shared_warmup=args.shared_warmup)
+        elapsed = time.perf_counter() - start
+        print_estimates(merge_replications(runs, args.confidence), args.confidence)
+        if args.warmup:
+            t_w = [r["warmup"] for r in runs]
+            print(f"\nРазгон (MSER-5): t_w от {min(t_w):.2f} до {max(t_w):.2f}, "
+                  f"в среднем {sum(t_w) / len(t_w):.2f}")
+    print(f"\nВремя: {elapsed:.2f} с на {args.replications} " + ("пар" if args.antithetic else "прогонов"))
+
+
+if __name__ == "__main__":
+    main()
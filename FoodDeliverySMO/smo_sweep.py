@@ -0,0 +1,110 @@
+import argparse
+import csv
+import itertools
+import json
+import os
+import sys
+from concurrent.futures import ProcessPoolExecutor, as_completed
+from typing import List, Optional, Set
+
+from smo_batch import MODEL_PARAMS, RecordWriter, expand_runs, load_scenario, run_job
+
+
+def expand_grid(scenario) -> List[dict]:
+    # Сетка grid = {параметр: [значения, ...]} раскрывается декартовым
+    # произведением и умножается на список runs: каждая точка — прогон
+    # с params прогона, дополненными значениями точки.
+    if isinstance(scenario, list):
+        scenario = {"runs": scenario}
+    scenario = dict(scenario)
+    grid = scenario.pop("grid", {})
+    unknown = set(grid) - set(MODEL_PARAMS)
+    if unknown:
+        raise ValueError(f"сетка: неизвестные параметры {sorted(unknown)}")
+    names = list(grid)
+    runs = scenario.pop("runs", None) or [{}]
+
+    swept = []
+    for run in runs:
+        for values in itertools.product(*(grid[n] for n in names)):
+            point = dict(zip(names, values))
+            label = ",".join(f"{n}={v}" for n, v in point.items())
+            base = run.get("name", scenario.get("name", "sweep"))
+            swept.append({**run,
+                          "name": f"{base}[{label}]" if label else base,
+                          "params": {**run.get("params", {}), **point}})
+    scenario["runs"] = swept
+    return expand_runs(scenario)
+
+
+def completed_jobs(path: str, fmt: str) -> Set[str]:
+    # job_id уже записанных прогонов. Оборванная при аварии последняя строка
+    # отрезается, чтобы дозапись начиналась с новой строки.
+    if not os.path.exists(path):
+        return set()
+    with open(path, "rb+") as f:
+        data = f.read()
+        end = data.rfind(b"\n") + 1
+        if end != len(data):
+            f.truncate(end)
+    lines = data[:end].decode("utf-8").splitlines()
+
+    if fmt == "csv":
+        if not lines:
+            return set()
+        reader = csv.DictReader(lines)
+        if reader.fieldnames is None or "job_id" not in reader.fieldnames:
+            raise ValueError(f"{path}: нет столбца job_id — это не таблица развёртки")
+        return {row["job_id"] for row in reader}
+    return {json.loads(line)["job_id"] for line in lines if line.strip()}
+
+
+def run_sweep(scenario, output: str, fmt: str = "csv", workers: Optional[int] = None,
+              restart: bool = False) -> tuple:
+    # Точки сетки считаются на пуле процессов, записи дописываются в output
+    # по мере готовности; при повторном запуске готовые job_id пропускаются.
+    jobs = expand_grid(scenario)
+    done = set() if restart else completed_jobs(output, fmt)
+    pending = [job for job in jobs if job["job_id"] not in done]
+
+    append = not restart and os.path.exists(output) and os.path.getsize(output) > 0
+    fields = None
+    if append and fmt == "csv":
+        with open(output, encoding="utf-8", newline="") as f:
+            fields = next(csv.reader(f))
+    with open(output, "a" if append else "w", encoding="utf-8", newline="") as out:
+        writer = RecordWriter(out, fmt, header=not append, fields=fields)
+        workers = workers or os.cpu_count() or 1
+        if workers == 1:
+            for job in pending:
+                writer.write(run_job(job))
+        else:
+            with ProcessPoolExecutor(max_workers=workers) as pool:
+                futures = [pool.submit(run_job, job) for job in pending]
+                for future in as_completed(futures):
+                    writer.write(future.result())
+    return len(pending), len(jobs) - len(pending)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Развёртка SMO по сетке параметров")
+    parser.add_argument("scenario", help="сценарий .json/.toml с ключом grid")
+    parser.add_argument("-o", "--output", required=True, help="таблица результатов (.csv или .jsonl)")
+    parser.add_argument("--format", choices=("jsonl", "csv"), default=None,
+                        help="формат (по умолчанию по расширению, иначе jsonl)")
+    parser.add_argument("--workers", type=int, default=None, help="процессов (по умолчанию все ядра)")
+    parser.add_argument("--restart", action="store_true",
+                        help="начать заново, не продолжая уже записанную таблицу")
+    args = parser.parse_args()
+
+    fmt = args.format or ("csv" if args.output.endswith(".csv") else "jsonl")
+    try:
+        ran, skipped = run_sweep(load_scenario(args.scenario), args.output, fmt,
+                                 args.workers, args.restart)
+    except (OSError, ValueError) as e:
+        parser.error(str(e))
+    print(f"Развёртка: посчитано {ran}, пропущено готовых {skipped}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
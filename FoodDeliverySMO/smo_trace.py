@@ -0,0 +1,433 @@
+import argparse
+import array
+import mmap
+import os
+import struct
+import sys
+import threading
+import time
+import zlib
+from bisect import bisect_left
+from collections import deque
+from dataclasses import dataclass
+from itertools import accumulate
+from typing import Iterator, List, Optional
+
+from smo_food_center import SMO, Event, EventType, TraceLevel
+
+
+# Двоичный журнал событий SMO — приёмник SMO(trace_sink=TraceWriter(...)).
+# Файл:
+#   FILE_HEAD: MAGIC, версия;
+#   блоки по block_events событий: BLOCK_HEAD (размер сжатых данных, событий,
+#     время первого и последнего события) и zlib от столбцов блока: COLUMNS
+#     (длины трёх varint-столбцов), тип события — байт на событие;
+#     приращения битового образа времени (для t >= 0 образ IEEE 754
+#     монотонен, приращения неотрицательны и время восстанавливается точно)
+#     по 8 байт, разложенные по байтовым плоскостям: сначала младшие байты
+#     всех приращений, затем следующие и т.д. — старшие плоскости почти
+#     постоянны и хорошо сжимаются, а раскладка идёт срезами без цикла на
+#     событие; затем varint (LEB128): restaurant_id + 1, order_id
+#     разностью с предыдущим событием блока (zigzag: номера заказов ресторанов
+#     растут вместе, разности малы), operator_id + 1 (-1 -> 0);
+#   при закрытии — индекс: INDEX_ENTRY на блок, затем TRAILER (число блоков,
+#     смещение индекса, END_MAGIC).
+# Если прогон прерван и индекса нет, читатель восстанавливает его проходом
+# по заголовкам блоков (недописанный последний блок отбрасывается).
+# buffer_pos и wait_time не пишутся: ожидание — разность времени
+# ORDER_TO_OPERATOR и поступления того же заказа.
+MAGIC = b"SMOTRACE"
+END_MAGIC = b"SMOTEND\0"
+VERSION = 1
+FILE_HEAD = struct.Struct("<8sI")
+BLOCK_HEAD = struct.Struct("<IIdd")
+COLUMNS = struct.Struct("<III")
+INDEX_ENTRY = struct.Struct("<QIIdd")   # смещение блока и поля BLOCK_HEAD
+TRAILER = struct.Struct("<QQ8s")
+BLOCK_EVENTS = 65536
+
+_SWAP = sys.byteorder == "big"
+
+
+def encode_varints(values) -> bytes:
+    # По 7 бит на байт, старший бит — "дальше продолжение"; столбец из
+    # значений < 128 (типичные номера ресторанов и операторов) — байт на значение
+    if max(values, default=0) < 0x80:
+        return bytes(values)
+    out = bytearray()
+    append = out.append
+    for v in values:
+        while v >= 0x80:
+            append(v & 0x7F | 0x80)
+            v >>= 7
+        append(v)
+    return bytes(out)
+
+
+def decode_varints(data: bytes) -> List[int]:
+    if data.isascii():
+        return list(data)
+    values = []
+    v = shift = 0
+    for b in data:
+        v |= (b & 0x7F) << shift
+        if b & 0x80:
+            shift += 7
+        else:
+            values.append(v)
+            v = shift = 0
+    return values
+
+
+def _time_bits(times) -> array.array:
+    bits = array.array("Q")
+    bits.frombytes(array.array("d", times).tobytes())
+    return bits
+
+
+def _planes(deltas: List[int]) -> bytes:
+    raw = array.array("Q", deltas)
+    if _SWAP:
+        raw.byteswap()
+    raw = raw.tobytes()
+    return b"".join(raw[i::8] for i in range(8))
+
+
+def _unplanes(data: bytes, n: int) -> array.array:
+    raw = bytearray(8 * n)
+    for i in range(8):
+        raw[i::8] = data[i * n:(i + 1) * n]
+    deltas = array.array("Q", raw)
+    if _SWAP:
+        deltas.byteswap()
+    return deltas
+
+
+def encode_block(events: List[Event], level: int = 6) -> bytes:
+    # Блок целиком: BLOCK_HEAD и сжатые столбцы
+    times = [ev.time for ev in events]
+    bits = _time_bits(times)
+    deltas = [b - a for a, b in zip(bits, bits[1:])]
+    if times[0] < 0 or min(deltas, default=0) < 0:
+        raise ValueError("журнал: время событий должно быть неотрицательным и неубывающим")
+    orders = [ev.order_id for ev in events]
+    order_deltas = [d << 1 if d >= 0 else (~d << 1) | 1 for d in map(int.__sub__, orders, [-1] + orders)]
+    columns = [encode_varints([ev.restaurant_id + 1 for ev in events]),
+               encode_varints(order_deltas),
+               encode_varints([ev.operator_id + 1 for ev in events])]
+    types = bytes([ev.etype._value_ for ev in events])   # без Enum.__hash__ на событие
+    payload = zlib.compress(b"".join([COLUMNS.pack(*map(len, columns)), types, _planes(deltas), *columns]),
+                            level)
+    return BLOCK_HEAD.pack(len(payload), len(times), times[0], times[-1]) + payload
+
+
+class TraceWriter:
+    # Приёмник событий SMO: копит события блока (сами объекты Event — на шаге
+    # только append) и по заполнении пишет блок столбцами. Обязательно
+    # закрыть (close или with), иначе в файле не будет индекса.
+    def __init__(self, path: str, block_events: int = BLOCK_EVENTS, level: int = 6):
+        if block_events < 1:
+            raise ValueError("block_events должно быть >= 1")
+        self.path = path
+        self.block_events = block_events
+        self.level = level
+        self.events = 0
+        self._file = open(path, "wb")
+        self._file.write(FILE_HEAD.pack(MAGIC, VERSION))
+        self._offset = FILE_HEAD.size
+        self._index: List[tuple] = []
+        self._new_block()
+
+    def _new_block(self):
+        self._events: List[Event] = []
+        self._append = self._events.append
+
+    def write(self, ev: Event):
+        self._append(ev)
+        if len(self._events) == self.block_events:
+            self.flush()
+
+    def flush(self):
+        if not self._events:
+            return
+        self._write_block(encode_block(self._events, self.level))
+        self._new_block()
+
+    def _write_block(self, block: bytes):
+        size, n, t_first, t_last = BLOCK_HEAD.unpack_from(block)
+        self._file.write(block)
+        self._index.append((self._offset, size, n, t_first, t_last))
+        self._offset += len(block)
+        self.events += n
+
+    def close(self):
+        if self._file.closed:
+            return
+        self.flush()
+        for entry in self._index:
+            self._file.write(INDEX_ENTRY.pack(*entry))
+        self._file.write(TRAILER.pack(len(self._index), self._offset, END_MAGIC))
+        self._file.close()
+
+    def __enter__(self) -> "TraceWriter":
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+class AsyncTraceWriter(TraceWriter):
+    # TraceWriter с записью в фоновом потоке: заполненный блок (список Event
+    # шага — буфер потока моделирования) передаётся писателю через deque
+    # (append/popleft атомарны), сам шаг на диск не ждёт. Передача — раз в
+    # блок, а не на событие. В пути не больше max_pending блоков (2 — двойная
+    # буферизация: один кодируется и пишется, второй копится). Когда все
+    # заняты, policy="block" ждёт освобождения, policy="drop" отбрасывает
+    # блок и считает события в dropped (в файле будет пропуск по времени).
+    # close() дописывает последний блок при любой policy, дожидается потока
+    # и пишет индекс; ошибка фоновой записи поднимается в flush/close.
+    POLICIES = ("block", "drop")
+
+    def __init__(self, path: str, block_events: int = BLOCK_EVENTS, level: int = 6,
+                 max_pending: int = 2, policy: str = "block"):
+        if policy not in self.POLICIES:
+            raise ValueError(f"policy: ожидается одно из {self.POLICIES}")
+        if max_pending < 1:
+            raise ValueError("max_pending должно быть >= 1")
+        super().__init__(path, block_events, level)
+        self.max_pending = max_pending
+        self.policy = policy
+        self.dropped = 0
+        self._queue: deque = deque()
+        self._slots = threading.Semaphore(max_pending)
+        self._ready = threading.Semaphore(0)
+        self._error: Optional[BaseException] = None
+        self._thread = threading.Thread(target=self._run, name="smo-trace-writer", daemon=True)
+        self._thread.start()
+
+    def _hand_over(self, events: Optional[List[Event]], block: bool):
+        if not self._slots.acquire(blocking=block):
+            self.dropped += len(events)
+            return
+        self._queue.append(events)
+        self._ready.release()
+
+    def flush(self):
+        self._check()
+        if not self._events:
+            return
+        self._hand_over(self._events, self.policy == "block")
+        self._new_block()
+
+    def _check(self):
+        if self._error is not None:
+            raise RuntimeError("журнал: ошибка фоновой записи") from self._error
+
+    def _run(self):
+        while True:
+            self._ready.acquire()
+            events = self._queue.popleft()
+            try:
+                if events is None:
+                    return
+                if self._error is None:
+                    self._write_block(encode_block(events, self.level))
+            except BaseException as e:
+                self._error = e
+            finally:
+                self._slots.release()
+
+    def close(self):
+        if self._file.closed:
+            return
+        if self._thread.is_alive():
+            if self._events:
+                self._hand_over(self._events, True)
+                self._new_block()
+            self._hand_over(None, True)
+            self._thread.join()
+        if self._error is not None:
+            self._file.close()
+            self._check()
+        super().close()
+
+
+@dataclass
+class TraceBlock:
+    times: array.array           # d
+    etypes: bytes                # EventType.value
+    restaurant_ids: List[int]
+    order_ids: List[int]
+    operator_ids: List[int]
+
+    def __len__(self) -> int:
+        return len(self.times)
+
+    def events(self, start: int = 0, stop: Optional[int] = None) -> Iterator[Event]:
+        for i in range(start, len(self.times) if stop is None else stop):
+            yield Event(self.times[i], EventType(self.etypes[i]), restaurant_id=self.restaurant_ids[i],
+                        order_id=self.order_ids[i], operator_id=self.operator_ids[i])
+
+
+class TraceReader:
+    # Чтение журнала через mmap: в памяти только индекс блоков и
+    # распакованный текущий блок, поэтому размер файла не ограничен памятью.
+    # Выборка по времени — полуинтервал [t_from, t_to).
+    def __init__(self, path: str):
+        self._file = open(path, "rb")
+        try:
+            if os.fstat(self._file.fileno()).st_size < FILE_HEAD.size:
+                raise ValueError("не журнал SMO")
+            self._map = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+        except Exception:
+            self._file.close()
+            raise
+        magic, version = FILE_HEAD.unpack_from(self._map)
+        if magic != MAGIC:
+            self.close()
+            raise ValueError("не журнал SMO")
+        if version != VERSION:
+            self.close()
+            raise ValueError(f"неподдерживаемая версия журнала {version}")
+        index = self._read_index()
+        self.complete = index is not None   # закрыт ли журнал писателем
+        self.index = index if index is not None else self._scan()
+        self._t_first = [e[3] for e in self.index]
+        self._t_last = [e[4] for e in self.index]
+
+    def _read_index(self) -> Optional[List[tuple]]:
+        m = self._map
+        if len(m) < FILE_HEAD.size + TRAILER.size:
+            return None
+        count, offset, end = TRAILER.unpack_from(m, len(m) - TRAILER.size)
+        if end != END_MAGIC or offset + count * INDEX_ENTRY.size != len(m) - TRAILER.size:
+            return None
+        return [INDEX_ENTRY.unpack_from(m, offset + i * INDEX_ENTRY.size) for i in range(count)]
+
+    def _scan(self) -> List[tuple]:
+        m = self._map
+        index = []
+        offset = FILE_HEAD.size
+        while offset + BLOCK_HEAD.size <= len(m):
+            size, n, t_first, t_last = BLOCK_HEAD.unpack_from(m, offset)
+            if offset + BLOCK_HEAD.size + size > len(m):
+                break
+            index.append((offset, size, n, t_first, t_last))
+            offset += BLOCK_HEAD.size + size
+        return index
+
+    def __len__(self) -> int:
+        return sum(e[2] for e in self.index)
+
+    def block(self, i: int) -> TraceBlock:
+        offset, size, n, t_first, _ = self.index[i]
+        start = offset + BLOCK_HEAD.size
+        data = zlib.decompress(self._map[start:start + size])
+        lengths = COLUMNS.unpack_from(data)
+        pos = COLUMNS.size
+        etypes = data[pos:pos + n]
+        pos += n
+        deltas = _unplanes(data[pos:pos + 8 * (n - 1)], n - 1)
+        pos += 8 * (n - 1)
+        columns = []
+        for length in lengths:
+            columns.append(decode_varints(data[pos:pos + length]))
+            pos += length
+        restaurants, orders, operators = columns
+        if pos != len(data) or any(len(c) != n for c in columns):
+            raise ValueError(f"журнал: блок {i} повреждён")
+        times = array.array("d")
+        times.frombytes(array.array("Q", accumulate(deltas, initial=_time_bits([t_first])[0])).tobytes())
+        orders = list(accumulate((z >> 1 if not z & 1 else ~(z >> 1) for z in orders), initial=-1))[1:]
+        return TraceBlock(times, etypes, [r - 1 for r in restaurants], orders, [p - 1 for p in operators])
+
+    def _block_range(self, t_from: Optional[float], t_to: Optional[float]) -> range:
+        first = 0 if t_from is None else bisect_left(self._t_last, t_from)
+        last = len(self.index) if t_to is None else bisect_left(self._t_first, t_to)
+        return range(first, last)
+
+    def blocks(self, t_from: Optional[float] = None, t_to: Optional[float] = None) -> Iterator[TraceBlock]:
+        # блоки, в которых есть события из [t_from, t_to) (границы по блокам)
+        for i in self._block_range(t_from, t_to):
+            yield self.block(i)
+
+    def events(self, t_from: Optional[float] = None, t_to: Optional[float] = None) -> Iterator[Event]:
+        for block in self.blocks(t_from, t_to):
+            start = 0 if t_from is None else bisect_left(block.times, t_from)
+            stop = len(block) if t_to is None else bisect_left(block.times, t_to)
+            yield from block.events(start, stop)
+
+    def close(self):
+        if getattr(self, "_map", None) is not None:
+            self._map.close()
+            self._map = None
+        self._file.close()
+
+    def __enter__(self) -> "TraceReader":
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Двоичный журнал событий SMO: запись и просмотр")
+    sub = parser.add_subparsers(dest="command", required=True)
+    rec = sub.add_parser("record", help="прогон с записью всех событий")
+    rec.add_argument("path")
+    rec.add_argument("--t-max", type=float, default=10000.0)
+    rec.add_argument("--seed", type=int, default=1)
+    rec.add_argument("--restaurants", type=int, default=15)
+    rec.add_argument("--operators", type=int, default=5)
+    rec.add_argument("--interval", type=float, default=10.0)
+    rec.add_argument("--op-mean", type=float, default=2.0)
+    rec.add_argument("--buffer-cap", type=int, default=3)
+    rec.add_argument("--block-events", type=int, default=BLOCK_EVENTS)
+    rec.add_argument("--policy", choices=AsyncTraceWriter.POLICIES, default="block",
+                     help="при отставании фоновой записи: ждать или отбрасывать блоки")
+    rec.add_argument("--sync", action="store_true", help="писать блоки в потоке моделирования")
+    show = sub.add_parser("show", help="события из промежутка времени [--from, --to)")
+    show.add_argument("path")
+    show.add_argument("--from", dest="t_from", type=float, default=None)
+    show.add_argument("--to", dest="t_to", type=float, default=None)
+    show.add_argument("--limit", type=int, default=80)
+    info = sub.add_parser("info", help="размер, блоки и события журнала")
+    info.add_argument("path")
+    args = parser.parse_args()
+
+    if args.command == "record":
+        start = time.perf_counter()
+        if args.sync:
+            writer = TraceWriter(args.path, args.block_events)
+        else:
+            writer = AsyncTraceWriter(args.path, args.block_events, policy=args.policy)
+        with writer:
+            smo = SMO(num_restaurants=args.restaurants, num_operators=args.operators,
+                      interval=args.interval, op_mean=args.op_mean, buffer_cap=args.buffer_cap,
+                      seed=args.seed, trace=TraceLevel.FULL, trace_sink=writer)
+            smo.run_until(args.t_max)
+        elapsed = time.perf_counter() - start
+        size = os.path.getsize(args.path)
+        print(f"Записано событий: {writer.events}, {size} байт ({size / max(writer.events, 1):.2f} байт "
+              f"на событие), счёт {elapsed:.2f} с")
+        if getattr(writer, "dropped", 0):
+            print(f"  ! отброшено событий: {writer.dropped} (запись не успевала, --policy drop)")
+    elif args.command == "show":
+        with TraceReader(args.path) as reader:
+            for i, ev in enumerate(reader.events(args.t_from, args.t_to)):
+                if i == args.limit:
+                    print("...")
+                    break
+                print(ev)
+    else:
+        with TraceReader(args.path) as reader:
+            n = len(reader)
+            size = os.path.getsize(args.path)
+            t = f"{reader._t_first[0]:.4f} .. {reader._t_last[-1]:.4f}" if reader.index else "-"
+            print(f"Событий: {n}, блоков: {len(reader.index)}, время {t}")
+            print(f"Размер: {size} байт, {size / max(n, 1):.2f} байт на событие"
+                  + ("" if reader.complete else " (журнал не закрыт: индекс восстановлен по блокам)"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,136 @@
+import argparse
+from typing import Callable, List, Optional, Sequence, Tuple
+
+from smo_food_center import SMO, TraceLevel
+
+
+# Сколько окон наблюдения берётся на горизонт пилотного прогона
+DEFAULT_WINDOWS = 500
+MSER_BATCH = 5
+
+
+def mser(series: Sequence[float], batch: int = MSER_BATCH) -> int:
+    # MSER-m (при batch = 5 — MSER-5): ряд сворачивается в средние по batch
+    # наблюдений, и отсекается столько первых средних d, сколько минимизирует
+    # sum_{i>d} (Y_i - mean_d)^2 / (k - d)^2 по d из первой половины ряда.
+    # Возвращает число отсекаемых исходных наблюдений.
+    k = len(series) // batch
+    if k < 2:
+        return 0
+    means = [sum(series[i * batch:(i + 1) * batch]) / batch for i in range(k)]
+    center = sum(means) / k   # сдвиг против потери точности в total_sq - n*m^2
+    means = [y - center for y in means]
+
+    # суффиксные суммы: проход с конца, d убывает
+    total = 0.0
+    total_sq = 0.0
+    scores: List[float] = [0.0] * k
+    for d in range(k - 1, -1, -1):
+        y = means[d]
+        total += y
+        total_sq += y * y
+        n = k - d
+        m = total / n
+        scores[d] = max(total_sq - n * m * m, 0.0) / (n * n)
+    best_d, best = 0, float("inf")
+    for d in range(k // 2 + 1):
+        if scores[d] < best:
+            best_d, best = d, scores[d]
+    return best_d * batch
+
+
+def collect_series(smo, t_end: float, window: float) -> Tuple[List[float], List[float], List[float]]:
+    # Ряды по окнам длины window: средняя длина буфера в окне и среднее
+    # ожидание заказов, обслуженных в окне (пустое окно повторяет
+    # предыдущее значение). Снимаются приращения накопленной статистики
+    # summary(), поэтому годится и SMO, и NativeSMO.
+    starts, buffer_len, waits = [], [], []
+    prev_time, prev_area, prev_sum, prev_count = smo.time, 0.0, 0.0, 0
+    last_wait = 0.0
+    t = smo.time
+    while t < t_end:
+        t = min(t + window, t_end)
+        smo.run_until(t)
+        s = smo.summary()
+        wait_sum = sum(n * m for n, m in zip(s["processed"], s["wait_mean"]))
+        count = sum(s["processed"])
+        dt = s["time"] - prev_time
+        starts.append(prev_time)
+        buffer_len.append((s["buffer_area"] - prev_area) / dt if dt > 0 else 0.0)
+        if count > prev_count:
+            last_wait = (wait_sum - prev_sum) / (count - prev_count)
+        waits.append(last_wait)
+        prev_time, prev_area, prev_sum, prev_count = s["time"], s["buffer_area"], wait_sum, count
+        if s["time"] <= starts[-1]:
+            break   # календарь пуст
+    return starts, buffer_len, waits
+
+
+def detect_warmup(smo, t_end: float, window: Optional[float] = None) -> float:
+    # Момент окончания разгона по MSER-5: наибольшее из отсечений рядов
+    # длины буфера и ожидания. smo прогоняется до t_end.
+    window = window or t_end / DEFAULT_WINDOWS
+    starts, buffer_len, waits = collect_series(smo, t_end, window)
+    d = max(mser(buffer_len), mser(waits))
+    return starts[d] if d < len(starts) else 0.0
+
+
+def _events(s: dict) -> int:
+    # события прогона по счётчикам summary(): поступления + завершения
+    return s["total_generated"] + s["total_processed"]
+
+
+def run_with_warmup(make_model: Callable[[], object], t_max: float,
+                    window: Optional[float] = None) -> Tuple[object, float, int]:
+    # Пилотный прогон до t_max определяет t_w (detect_warmup доводит его
+    # до конца); затем модель с тем же seed доводится до t_w заново,
+    # статистика сбрасывается и счёт идёт до t_max. Снимки пилота не
+    # хранятся, поэтому память не зависит от размера модели, а затраты —
+    # два прогона; без разгона пилотный прогон и есть результат.
+    # Возвращает модель, t_w и число событий обоих прогонов.
+    pilot = make_model()
+    t_w = detect_warmup(pilot, t_max, window)
+    events = _events(pilot.summary())
+    if t_w <= 0.0:
+        return pilot, 0.0, events
+    smo = make_model()
+    events += smo.run_until(t_w)
+    smo.reset_statistics()
+    events += smo.run_until(t_max)
+    return smo, t_w, events
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Прогон SMO с отсечением разгона (MSER-5)")
+    parser.add_argument("--t-max", type=float, default=10000.0)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--window", type=float, default=None,
+                        help=f"длина окна наблюдения (по умолчанию t_max / {DEFAULT_WINDOWS})")
+    parser.add_argument("--backend", choices=("python", "native"), default="python")
+    parser.add_argument("--restaurants", type=int, default=15)
+    parser.add_argument("--operators", type=int, default=5)
+    parser.add_argument("--interval", type=float, default=10.0)
+    parser.add_argument("--op-mean", type=float, default=2.0)
+    parser.add_argument("--buffer-cap", type=int, default=3)
+    args = parser.parse_args()
+
+    params = dict(num_restaurants=args.restaurants, num_operators=args.operators,
+                  interval=args.interval, op_mean=args.op_mean, buffer_cap=args.buffer_cap,
+                  seed=args.seed)
+    if args.backend == "native":
+        from smo_native import NativeSMO
+
+        def make_model():
+            return NativeSMO(**params)
+    else:
+        def make_model():
+            return SMO(**params, trace=TraceLevel.OFF)
+
+    smo, t_w, _ = run_with_warmup(make_model, args.t_max, args.window)
+    print(f"Разгон (MSER-5): t_w = {t_w:.2f} из {args.t_max:.2f}")
+    smo.print_statistics()
+    smo.print_extended_statistics()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,71 @@
+import random
+import unittest
+
+from smo_batch_means import analyze, analyze_all, lag1_autocorrelation
+from smo_food_center import SMO, BatchMeans, TraceLevel
+from smo_native import NativeSMO, native_available
+
+PARAMS = dict(num_restaurants=6, num_operators=4, interval=1.0, op_mean=3.0, buffer_cap=10, seed=3)
+
+
+class BatchMeansTest(unittest.TestCase):
+    def test_rejects_odd_or_small_max_batches(self):
+        for max_batches in (0, 1, 3, 63):
+            with self.subTest(max_batches=max_batches), self.assertRaises(ValueError):
+                BatchMeans(max_batches)
+        BatchMeans(2).add(1.0)
+
+    def test_full_batches_merge_in_pairs(self):
+        bm = BatchMeans(max_batches=4)
+        for x in range(1, 12):
+            bm.add(float(x))
+        # 8 наблюдений — два пакета по 4 (после двух слияний), остальные 3 — в неполном
+        self.assertEqual(bm.size, 4.0)
+        self.assertEqual(bm.sums, [10.0, 26.0])
+        self.assertEqual(bm.weights, [4.0, 4.0])
+        self.assertEqual(bm.means(), [2.5, 6.5])
+        self.assertEqual(bm.total(), (66.0, 11.0))
+
+    def test_independent_observations(self):
+        rng = random.Random(1)
+        bm = BatchMeans(64)
+        for _ in range(20000):
+            bm.add(rng.gauss(5.0, 1.0))
+        est = analyze(bm)
+        self.assertTrue(est.independent)
+        self.assertGreaterEqual(est.batches, 10)
+        self.assertLess(abs(est.mean - 5.0), 3 * est.half_width)
+        self.assertLess(est.half_width, 0.05)
+
+    def test_correlated_batches_are_merged(self):
+        # AR(1) с сильной корреляцией: мелкие пакеты зависимы и сливаются
+        rng = random.Random(2)
+        bm = BatchMeans(64)
+        x = 0.0
+        for _ in range(20000):
+            x = 0.999 * x + rng.gauss(0.0, 1.0)
+            bm.add(x)
+        self.assertGreater(lag1_autocorrelation(bm.means()), 0.5)
+        self.assertLess(analyze(bm).batches, len(bm.sums))
+
+    def test_point_estimate_matches_summary(self):
+        smo = SMO(trace=TraceLevel.OFF, batch_means=True, **PARAMS)
+        smo.run_until(5000.0)
+        s = smo.summary()
+        wait = sum(n * w for n, w in zip(s["processed"], s["wait_mean"])) / sum(s["processed"])
+        self.assertAlmostEqual(analyze_all(smo)["wait"].mean, wait, places=9)
+
+    @unittest.skipUnless(native_available(), "нативный движок не собран")
+    def test_native_batch_means_match_python(self):
+        smo = SMO(trace=TraceLevel.OFF, batch_means=True, **PARAMS)
+        native = NativeSMO(batch_means=True, **PARAMS)
+        smo.run_until(5000.0)
+        native.run_until(5000.0)
+        for key, bm in smo.batch_means().items():
+            with self.subTest(key=key):
+                other = native.batch_means()[key]
+                self.assertEqual((other.sums, other.weights, other.size), (bm.sums, bm.weights, bm.size))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,116 @@
+import struct
+import unittest
+
+from smo_checkpoint import (HEADER, OPERATOR_COLUMNS, OPERATOR_DRAWN, RESTAURANT_COLUMNS, _width, dumps,
+                            loads, with_seed)
+from smo_food_center import EVENT_SETS, SMO, TraceLevel
+from smo_native import NativeSMO, native_available
+
+PARAMS = dict(num_restaurants=5, num_operators=3, interval=1.2, op_mean=3.0, buffer_cap=6, seed=11)
+OPTIONS = [dict(), dict(crn=True, antithetic=True), dict(batch_means=True, regenerative=True)]
+BACKENDS = ["python"] + (["native"] if native_available() else [])
+
+
+def make(backend: str, **options):
+    if backend == "native":
+        return NativeSMO(**PARAMS, **options)
+    return SMO(trace=TraceLevel.OFF, **PARAMS, **options)
+
+
+def load(data: bytes, backend: str):
+    return loads(data, backend, **({"trace": TraceLevel.OFF} if backend == "python" else {}))
+
+
+class CheckpointRoundTripTest(unittest.TestCase):
+    def test_dump_load_dump_is_identity(self):
+        for backend in BACKENDS:
+            for options in OPTIONS:
+                with self.subTest(backend=backend, **options):
+                    smo = make(backend, **options)
+                    smo.run_until(300.0)
+                    data = dumps(smo)
+                    self.assertEqual(dumps(load(data, backend)), data)
+
+    def test_restored_run_continues_like_the_original(self):
+        for backend in BACKENDS:
+            for options in OPTIONS:
+                with self.subTest(backend=backend, **options):
+                    smo = make(backend, **options)
+                    smo.run_until(300.0)
+                    restored = load(dumps(smo), backend)
+                    smo.run_until(600.0)
+                    restored.run_until(600.0)
+                    self.assertEqual(restored.summary(), smo.summary())
+
+    def test_every_event_set_restores(self):
+        smo = make("python")
+        smo.run_until(300.0)
+        data = dumps(smo)
+        smo.run_until(600.0)
+        for event_set in EVENT_SETS:
+            with self.subTest(event_set=event_set):
+                restored = loads(data, trace=TraceLevel.OFF, event_set=event_set)
+                restored.run_until(600.0)
+                self.assertEqual(restored.summary(), smo.summary())
+
+    @unittest.skipUnless(native_available(), "нативный движок не собран")
+    def test_engines_write_the_same_bytes_and_continue_each_other(self):
+        for options in OPTIONS:
+            with self.subTest(**options):
+                py, native = make("python", **options), make("native", **options)
+                py.run_until(300.0)
+                native.run_until(300.0)
+                data = dumps(py)
+                self.assertEqual(dumps(native), data)
+                across = load(data, "native")
+                py.run_until(600.0)
+                across.run_until(600.0)
+                self.assertEqual(across.summary(), py.summary())
+
+    def test_with_seed_restarts_streams(self):
+        smo = make("python")
+        smo.run_until(300.0)
+        a = load(with_seed(dumps(smo), 99), "python")
+        b = load(with_seed(dumps(smo), 99), "python")
+        a.run_until(600.0)
+        b.run_until(600.0)
+        smo.run_until(600.0)
+        self.assertEqual(a.summary(), b.summary())
+        self.assertNotEqual(a.summary(), smo.summary())
+
+
+class CheckpointValidationTest(unittest.TestCase):
+    def setUp(self):
+        smo = make("python")
+        smo.run_until(300.0)
+        self.data = dumps(smo)
+
+    def assertRejected(self, data: bytes, reason: str):
+        for backend in BACKENDS:
+            with self.subTest(backend=backend):
+                with self.assertRaisesRegex(ValueError, reason):
+                    load(data, backend)
+
+    def test_pending_arrival_without_generated_order(self):
+        b = bytearray(self.data)
+        struct.pack_into("<q", b, HEADER.size, 0)   # generated ресторана 0
+        self.assertRejected(bytes(b), "неверные счётчики ресторанов")
+
+    def test_stream_position_beyond_events(self):
+        n, m = PARAMS["num_restaurants"], PARAMS["num_operators"]
+        b = bytearray(self.data)
+        start = HEADER.size + _width(RESTAURANT_COLUMNS) * n + _width(OPERATOR_COLUMNS[:OPERATOR_DRAWN]) * m
+        struct.pack_into("<Q", b, start, 1 << 40)   # выдано потоком оператора 0
+        self.assertRejected(bytes(b), "неверные позиции потоков")
+
+    def test_truncated(self):
+        for size in (0, HEADER.size - 1, HEADER.size + 10, len(self.data) - 1):
+            with self.subTest(size=size):
+                self.assertRejected(self.data[:size], "обрезан|не снимок SMO")
+
+    def test_trailing_bytes(self):
+        self.assertRejected(self.data + b"\0", "лишние данные")
+
+
+if __name__ == "__main__":
+    unittest.main()
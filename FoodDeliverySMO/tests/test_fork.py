@@ -0,0 +1,81 @@
+import unittest
+
+from smo_checkpoint import HEADER, dumps, read_header, with_changes
+from smo_fork import fork, run_branches
+from smo_food_center import EVENT_SETS, SMO, TraceLevel
+from smo_native import NativeSMO, native_available
+
+# перегрузка: к моменту ветвления в буфере есть заказы
+PARAMS = dict(num_restaurants=6, num_operators=3, interval=1.0, op_mean=1.0, buffer_cap=8, seed=5)
+
+
+def running(t: float = 200.0, **options) -> SMO:
+    smo = SMO(trace=TraceLevel.OFF, **PARAMS, **options)
+    smo.run_until(t)
+    return smo
+
+
+class ForkTest(unittest.TestCase):
+    def test_fork_continues_like_the_source(self):
+        for event_set in EVENT_SETS:
+            with self.subTest(event_set=event_set):
+                smo = running(event_set=event_set)
+                branch = fork(smo)
+                smo.run_until(400.0)
+                branch.run_until(400.0)
+                self.assertEqual(branch.summary(), smo.summary())
+
+    def test_fork_keeps_event_set(self):
+        for event_set in EVENT_SETS:
+            with self.subTest(event_set=event_set):
+                smo = running(event_set=event_set)
+                branch = fork(smo, num_operators=5)
+                self.assertEqual(branch.event_set, event_set)
+                self.assertIs(type(branch.event_queue), type(smo.event_queue))
+
+    def test_branches_do_not_touch_source(self):
+        smo = running()
+        before = dumps(smo)
+        results = run_branches(smo, 100.0, [{}, {"num_operators": 5}, {"op_mean": 0.5}], workers=1)
+        self.assertEqual(dumps(smo), before)
+        self.assertLess(results[1]["wait_mean"], results[0]["wait_mean"])
+
+    def test_op_mean_rescales_buffered_crn_orders(self):
+        smo = running(crn=True)
+        self.assertGreater(len(smo.buffer), 0)
+        branch = fork(smo, op_mean=3.0)
+        self.assertEqual([o.service_time * 3.0 for o in smo.buffer.orders],
+                         [o.service_time for o in branch.buffer.orders])
+        # у обслуживаемых сейчас заказов время не меняется
+        self.assertEqual([op.current_order for op in smo.operators],
+                         [op.current_order for op in branch.operators])
+
+    def test_op_mean_without_crn_keeps_buffer(self):
+        smo = running()
+        data = dumps(smo)
+        changed = with_changes(data, op_mean=3.0)
+        self.assertEqual(read_header(changed)["op_mean"], 3.0)
+        self.assertEqual(changed[HEADER.size:], data[HEADER.size:])
+
+    def test_rejects_fewer_operators_and_small_buffer(self):
+        data = dumps(running())
+        with self.assertRaises(ValueError):
+            with_changes(data, num_operators=2)
+        with self.assertRaises(ValueError):
+            with_changes(data, buffer_cap=0)
+
+    @unittest.skipUnless(native_available(), "нативный движок не собран")
+    def test_native_fork_matches_python_fork(self):
+        for crn in (False, True):
+            with self.subTest(crn=crn):
+                smo = running(crn=crn)
+                py = fork(smo, num_operators=4, op_mean=1.5)
+                native = fork(smo, backend="native", num_operators=4, op_mean=1.5)
+                self.assertIsInstance(native, NativeSMO)
+                py.run_until(400.0)
+                native.run_until(400.0)
+                self.assertEqual(native.summary(), py.summary())
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,60 @@
+import unittest
+
+from smo_food_center import EVENT_SETS, SMO, TraceLevel
+from smo_native import NativeSMO, native_available
+
+# (параметры, t_max): низкая загрузка, перегрузка с отказами, сотни операторов
+# (засев потоков группами), crn и антитетические потоки
+CASES = [
+    (dict(num_restaurants=15, num_operators=5, interval=10.0, op_mean=2.0, buffer_cap=3, seed=1), 5000.0),
+    (dict(seed=2**40 + 5, num_operators=30, interval=0.1, buffer_cap=10), 300.0),
+    (dict(num_restaurants=200, num_operators=500, interval=2.0, op_mean=4.5, buffer_cap=100, seed=-3), 100.0),
+    (dict(seed=9, crn=True, antithetic=True, num_operators=30, interval=0.1, buffer_cap=10), 300.0),
+]
+
+
+def run_python(params: dict, t_max: float, event_set: str):
+    smo = SMO(trace=TraceLevel.OFF, event_set=event_set, **params)
+    events = 0
+    while smo.time < t_max and smo.step():
+        events += 1
+    return events, smo.summary()
+
+
+@unittest.skipUnless(native_available(), "нативный движок не собран")
+class NativeParityTest(unittest.TestCase):
+    def test_same_events_and_summary_for_every_event_set(self):
+        for params, t_max in CASES:
+            native = NativeSMO(**params)
+            expected = (native.run_until(t_max), native.summary())
+            for event_set in EVENT_SETS:
+                with self.subTest(params=params, event_set=event_set):
+                    self.assertEqual(run_python(params, t_max, event_set), expected)
+
+    def test_run_until_in_parts(self):
+        params, t_max = CASES[2]
+        whole = NativeSMO(**params)
+        whole.run_until(t_max)
+        parts = NativeSMO(**params)
+        for t in (10.0, 10.5, 60.0, t_max):
+            parts.run_until(t)
+        self.assertEqual(parts.summary(), whole.summary())
+
+
+@unittest.skipUnless(native_available(), "нативный движок не собран")
+class NativeArgumentsTest(unittest.TestCase):
+    def test_rejects_values_outside_int32(self):
+        for kwargs in (dict(num_operators=1 << 32), dict(buffer_cap=2**31), dict(num_restaurants=-2**31 - 1)):
+            with self.subTest(**kwargs), self.assertRaises(ValueError):
+                NativeSMO(**kwargs)
+
+    def test_accepts_int32_bounds(self):
+        NativeSMO(buffer_cap=2**31 - 1).run_until(10.0)
+
+    def test_rejects_negative_max_events(self):
+        with self.assertRaises(ValueError):
+            NativeSMO().run_until(10.0, max_events=-1)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,87 @@
+import contextlib
+import io
+import os
+import tempfile
+import unittest
+
+from smo_food_center import SMO, TraceLevel
+from smo_replay import ArrivalLog, convert
+
+# время, ресторан, время обслуживания (пусто — разыграть потоком оператора)
+ROWS = [(100.0, 0, 1.5), (100.5, 1, None), (101.0, 0, 0.25), (101.0, 2, 4.0), (103.5, 1, 0.5),
+        (104.0, 2, None), (110.0, 0, 2.0)]
+
+
+def write_csv(path: str, rows=ROWS):
+    with open(path, "w") as f:
+        f.write("time,restaurant_id,service_time\n")
+        for t, rid, service in rows:
+            f.write(f"{t},{rid},{'' if service is None else service}\n")
+
+
+class ReplayTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory()
+        self.csv = os.path.join(self.dir.name, "arrivals.csv")
+        write_csv(self.csv)
+
+    def tearDown(self):
+        self.dir.cleanup()
+
+    def replay(self, path: str, num_operators: int = 2, **options) -> SMO:
+        with ArrivalLog(path, **options) as arrivals:
+            smo = SMO(num_restaurants=3, num_operators=num_operators, buffer_cap=1, seed=1, arrivals=arrivals,
+                      trace=TraceLevel.OFF)
+            smo.run_until(1000.0)
+        return smo
+
+    def test_orders_follow_the_log(self):
+        smo = self.replay(self.csv)
+        s = smo.summary()
+        self.assertEqual(s["total_generated"], len(ROWS))
+        self.assertEqual(s["generated"], [3, 2, 2])
+        self.assertEqual(s["total_processed"] + s["total_rejected"], len(ROWS))
+        # операторов хватает всем: пребывание — время обслуживания из журнала
+        s = self.replay(self.csv, num_operators=5).summary()
+        self.assertEqual((s["system_min"][0], s["system_max"][0]), (0.25, 2.0))
+        self.assertEqual(s["wait_max"], [0.0, 0.0, 0.0])
+
+    def test_binary_log_replays_the_same(self):
+        path = os.path.join(self.dir.name, "arrivals.bin")
+        self.assertEqual(convert(self.csv, path), len(ROWS))
+        self.assertEqual(self.replay(path).summary(), self.replay(self.csv).summary())
+
+    def test_small_chunks_replay_the_same(self):
+        self.assertEqual(self.replay(self.csv, chunk=1, prefetch=1).summary(), self.replay(self.csv).summary())
+
+    def test_origin_shifts_times(self):
+        # по умолчанию отсчёт от первой записи (100.0)
+        self.assertAlmostEqual(self.replay(self.csv, origin=0.0).time - self.replay(self.csv).time, 100.0)
+
+    def test_rejects_decreasing_time_and_unknown_restaurant(self):
+        for rows in ([(1.0, 0, None), (0.5, 1, None)], [(1.0, 5, None)]):
+            with self.subTest(rows=rows):
+                write_csv(self.csv, rows)
+                with self.assertRaises(ValueError):
+                    self.replay(self.csv)
+
+    def test_print_state_shows_pending_replay_arrival(self):
+        with ArrivalLog(self.csv) as arrivals:
+            smo = SMO(num_restaurants=3, num_operators=2, buffer_cap=1, seed=1, arrivals=arrivals,
+                      trace=TraceLevel.OFF)
+            smo.step()
+            out = io.StringIO()
+            with contextlib.redirect_stdout(out):
+                smo.print_state()
+            self.assertIn("следующее — ресторан 1, t=0.50", out.getvalue())
+            self.assertNotIn("inf", out.getvalue())
+
+            smo.run_until(1000.0)
+            out = io.StringIO()
+            with contextlib.redirect_stdout(out):
+                smo.print_state()
+            self.assertIn("журнал исчерпан", out.getvalue())
+
+
+if __name__ == "__main__":
+    unittest.main()
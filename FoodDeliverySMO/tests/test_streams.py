@@ -0,0 +1,96 @@
+import math
+import unittest
+
+from smo_food_center import SMO, ExponentialStream, RandomStream, TraceLevel, split_key
+from smo_replications import replication_seed
+
+
+def draws(stream, n):
+    return [stream.next() for _ in range(n)]
+
+
+def correlation(xs, ys):
+    n = len(xs)
+    mx, my = sum(xs) / n, sum(ys) / n
+    cov = sum((x - mx) * (y - my) for x, y in zip(xs, ys))
+    vx = sum((x - mx) ** 2 for x in xs)
+    vy = sum((y - my) ** 2 for y in ys)
+    return cov / math.sqrt(vx * vy)
+
+
+class StreamTest(unittest.TestCase):
+    def test_same_key_same_sequence(self):
+        self.assertEqual(draws(RandomStream(42), 500), draws(RandomStream(42), 500))
+        self.assertEqual(draws(RandomStream(42).split(3), 500), draws(RandomStream(42).split(3), 500))
+
+    def test_seek_matches_sequential_draws(self):
+        # в том числе дальше одного вызова getrandbits при пропуске (SKIP)
+        n = RandomStream.SKIP + 1000
+        for stream_type in (RandomStream, ExponentialStream):
+            for antithetic in (False, True):
+                values = draws(stream_type(7, antithetic), n + 3)
+                for k in (0, 1, 999, n):
+                    stream = stream_type(7, antithetic)
+                    stream.seek(k)
+                    self.assertEqual(stream.tell(), k)
+                    self.assertEqual(draws(stream, 3), values[k:k + 3])
+                    self.assertEqual(stream.tell(), k + 3)
+
+    def test_antithetic_pairs(self):
+        u = draws(RandomStream(5), 200)
+        v = draws(RandomStream(5, antithetic=True), 200)
+        self.assertTrue(all(a + b == 1.0 - 2.0 ** -53 for a, b in zip(u, v)))
+
+    def test_exponential_is_log_of_uniform(self):
+        u = draws(RandomStream(11), 200)
+        e = draws(ExponentialStream(11), 200)
+        self.assertEqual(e, [-math.log(1.0 - x) for x in u])
+
+    def test_expovariate_matches_next(self):
+        # быстрый путь Operator.start_service: expovariate, затем drawn += 1
+        for antithetic in (False, True):
+            values = draws(ExponentialStream(13, antithetic), 400)
+            for start in (0, 100):
+                stream = ExponentialStream(13, antithetic)
+                stream.seek(start)
+                fast = []
+                for _ in range(200):
+                    fast.append(stream.expovariate(0.25))
+                    stream.drawn += 1
+                self.assertEqual(fast, [v / 0.25 for v in values[start:start + 200]])
+                self.assertEqual(stream.tell(), start + 200)
+                self.assertEqual(stream.next(), values[start + 200])
+
+    def test_split_streams_are_independent(self):
+        # потоки репликаций и операторов одной репликации: без общих значений
+        # и без заметной корреляции
+        keys = [replication_seed(1, r) for r in range(8)]
+        keys += [split_key(keys[0], i) for i in range(8)]
+        self.assertEqual(len(set(keys)), len(keys))
+        sequences = [draws(RandomStream(k), 2000) for k in keys]
+        for i, a in enumerate(sequences):
+            self.assertAlmostEqual(sum(a) / len(a), 0.5, delta=0.03)
+            for b in sequences[i + 1:]:
+                self.assertFalse(set(a) & set(b))
+                self.assertLess(abs(correlation(a, b)), 0.1)
+
+    def test_replication_is_reproducible(self):
+        params = dict(num_restaurants=5, num_operators=3, interval=2.0, op_mean=2.0, buffer_cap=4)
+        summaries = []
+        for _ in range(2):
+            smo = SMO(**params, seed=replication_seed(1, 3), trace=TraceLevel.OFF)
+            smo.run_until(2000)
+            summaries.append(smo.summary())
+        self.assertEqual(summaries[0], summaries[1])
+        other = SMO(**params, seed=replication_seed(1, 4), trace=TraceLevel.OFF)
+        other.run_until(2000)
+        self.assertNotEqual(other.summary(), summaries[0])
+
+    def test_operator_stream_does_not_depend_on_model_size(self):
+        small = SMO(num_operators=2, seed=9, trace=TraceLevel.OFF)
+        large = SMO(num_operators=20, seed=9, trace=TraceLevel.OFF)
+        self.assertEqual(draws(small.operators[1].stream, 100), draws(large.operators[1].stream, 100))
+
+
+if __name__ == "__main__":
+    unittest.main()
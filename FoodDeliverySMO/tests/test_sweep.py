@@ -0,0 +1,77 @@
+import csv
+import json
+import os
+import tempfile
+import unittest
+
+from smo_sweep import completed_jobs, expand_grid, run_sweep
+
+SCENARIO = {
+    "t_max": 300.0,
+    "params": {"num_restaurants": 4, "interval": 1.0, "op_mean": 2.0},
+    "grid": {"num_operators": [2, 3], "buffer_cap": [1, 4]},
+}
+
+
+def read_records(path: str, fmt: str) -> dict:
+    with open(path, encoding="utf-8", newline="") as f:
+        if fmt == "csv":
+            rows = list(csv.DictReader(f))
+        else:
+            rows = [json.loads(line) for line in f]
+    ids = [row["job_id"] for row in rows]
+    assert len(ids) == len(set(ids)), "повторные job_id"
+    return {row["job_id"]: {k: v for k, v in row.items() if k != "wall_time"} for row in rows}
+
+
+class SweepTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory()
+
+    def tearDown(self):
+        self.dir.cleanup()
+
+    def test_grid_is_cartesian_product(self):
+        jobs = expand_grid(SCENARIO)
+        self.assertEqual(len(jobs), 4)
+        self.assertEqual(sorted((j["params"]["num_operators"], j["params"]["buffer_cap"]) for j in jobs),
+                         [(2, 1), (2, 4), (3, 1), (3, 4)])
+        self.assertEqual(len({j["job_id"] for j in jobs}), 4)
+        with self.assertRaises(ValueError):
+            expand_grid({**SCENARIO, "grid": {"speed": [1]}})
+
+    def test_resume_after_torn_last_line(self):
+        for fmt in ("jsonl", "csv"):
+            with self.subTest(fmt=fmt):
+                full = os.path.join(self.dir.name, f"full.{fmt}")
+                torn = os.path.join(self.dir.name, f"torn.{fmt}")
+                self.assertEqual(run_sweep(SCENARIO, full, fmt, workers=1), (4, 0))
+
+                # авария посреди записи третьей строки данных
+                with open(full, "rb") as f:
+                    lines = f.read().splitlines(keepends=True)
+                keep = 3 if fmt == "csv" else 2   # у csv первая строка — заголовок
+                with open(torn, "wb") as f:
+                    f.write(b"".join(lines[:keep]) + lines[keep][:len(lines[keep]) // 2])
+                self.assertEqual(len(completed_jobs(torn, fmt)), 2)
+
+                self.assertEqual(run_sweep(SCENARIO, torn, fmt, workers=1), (2, 2))
+                self.assertEqual(read_records(torn, fmt), read_records(full, fmt))
+                self.assertEqual(run_sweep(SCENARIO, torn, fmt, workers=1), (0, 4))
+
+    def test_restart_rewrites_table(self):
+        path = os.path.join(self.dir.name, "out.jsonl")
+        run_sweep(SCENARIO, path, "jsonl", workers=1)
+        self.assertEqual(run_sweep(SCENARIO, path, "jsonl", workers=1, restart=True), (4, 0))
+        self.assertEqual(len(read_records(path, "jsonl")), 4)
+
+    def test_csv_without_job_id_is_not_resumed(self):
+        path = os.path.join(self.dir.name, "other.csv")
+        with open(path, "w") as f:
+            f.write("a,b\n1,2\n")
+        with self.assertRaises(ValueError):
+            run_sweep(SCENARIO, path, "csv", workers=1)
+
+
+if __name__ == "__main__":
+    unittest.main()
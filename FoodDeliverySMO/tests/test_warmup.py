@@ -0,0 +1,83 @@
+import random
+import unittest
+
+from smo_food_center import SMO, TraceLevel
+from smo_warmup import MSER_BATCH, detect_warmup, mser, run_with_warmup
+
+# загрузка ~0.9 от пустого старта: заметный разгон
+PARAMS = dict(num_restaurants=6, num_operators=4, interval=1.0, op_mean=0.6, buffer_cap=50, seed=2)
+
+
+def mser_by_definition(series, batch=MSER_BATCH) -> int:
+    k = len(series) // batch
+    if k < 2:
+        return 0
+    means = [sum(series[i * batch:(i + 1) * batch]) / batch for i in range(k)]
+
+    def score(d):
+        tail = means[d:]
+        m = sum(tail) / len(tail)
+        return sum((y - m) ** 2 for y in tail) / len(tail) ** 2
+
+    return min(range(k // 2 + 1), key=score) * batch
+
+
+def make_model() -> SMO:
+    return SMO(trace=TraceLevel.OFF, **PARAMS)
+
+
+class MserTest(unittest.TestCase):
+    def test_cuts_the_transient(self):
+        rng = random.Random(1)
+        series = [10.0 - i * 0.1 + rng.gauss(0, 0.5) for i in range(100)] + [rng.gauss(0, 0.5) for _ in range(900)]
+        self.assertTrue(80 <= mser(series) <= 110, mser(series))
+
+    def test_stationary_series_keeps_almost_everything(self):
+        rng = random.Random(2)
+        series = [rng.gauss(3.0, 1.0) for _ in range(1000)]
+        self.assertLess(mser(series), 100)
+
+    def test_matches_definition(self):
+        rng = random.Random(3)
+        for n in (9, 10, 57, 400):
+            series = [rng.expovariate(1.0) + (5.0 if i < n // 7 else 0.0) for i in range(n)]
+            with self.subTest(n=n):
+                self.assertEqual(mser(series), mser_by_definition(series))
+
+    def test_short_series(self):
+        self.assertEqual(mser([]), 0)
+        self.assertEqual(mser([1.0] * (2 * MSER_BATCH - 1)), 0)
+
+
+class WarmupRunTest(unittest.TestCase):
+    def test_detects_warmup_from_empty_start(self):
+        t_w = detect_warmup(make_model(), 2000.0)
+        self.assertGreater(t_w, 0.0)
+        self.assertLess(t_w, 1000.0)
+
+    def test_run_with_warmup_equals_manual_truncation(self):
+        smo, t_w, events = run_with_warmup(make_model, 2000.0)
+        self.assertEqual(smo.stats_start, t_w)
+        manual = make_model()
+        manual.run_until(t_w)
+        manual.reset_statistics()
+        manual.run_until(2000.0)
+        self.assertEqual(smo.summary(), manual.summary())
+        # пилотный прогон до t_max, затем повтор до t_max
+        pilot = make_model()
+        pilot.run_until(2000.0)
+        s = pilot.summary()
+        self.assertGreater(events, s["total_generated"] + s["total_processed"])
+
+    def test_reset_statistics_starts_from_now(self):
+        smo = make_model()
+        smo.run_until(500.0)
+        smo.reset_statistics()
+        s = smo.summary()
+        self.assertEqual(s["stats_start"], smo.time)
+        self.assertEqual((s["total_generated"], s["total_processed"], s["total_rejected"]), (0, 0, 0))
+        self.assertEqual(s["processed"], [0] * PARAMS["num_restaurants"])
+
+
+if __name__ == "__main__":
+    unittest.main()